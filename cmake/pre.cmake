@@ -52,7 +52,10 @@ endif()
 set(CMAKE_INCLUDE_CURRENT_DIR ON)
 
 option(ENABLE_SYSTEMD "enable linking of systemd" ON)
+option(ENABLE_ZSTD "enable zstd compression in netHelper if available" ON)
+option(ENABLE_NETHELPER_METRICS "enable collection of per-connection metrics in netHelper" OFF)
 option(BUILD_TESTS "enable building of tests" ON)
+option(BUILD_BENCHMARKS "enable building of benchmarks" OFF)
 option(AUTORUN_TESTS "enable automatic runs of tests when building Release builds" ON)
 option(ENABLE_CCACHE "enables ccache if available" ON)
 option(ENABLE_STRIPPING "enable stripping of binary" ON)
@@ -0,0 +1,112 @@
+/*
+ * jsonArena.hpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#ifndef JSONARENA_HPP_
+#define JSONARENA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace bestsens {
+	namespace detail {
+		auto arena_allocate(size_t bytes, size_t alignment) -> void*;
+		auto arena_deallocate(void* p, size_t bytes, size_t alignment) noexcept -> void;
+	}  // namespace detail
+
+	/*!
+		@brief	stateless allocator taking memory from the resource of the innermost json_arena_scope of
+				the calling thread, or from the default resource outside of a scope
+
+		nlohmann::json default constructs its allocators, so the resource can not be carried by the
+		allocator. Every block records the resource it came from instead, which makes it safe to free
+		a block outside of the scope it was allocated in.
+	*/
+	template <typename T>
+	class arena_allocator {
+	public:
+		using value_type = T;
+
+		arena_allocator() noexcept = default;
+
+		template <typename U>
+		arena_allocator(const arena_allocator<U>& /*other*/) noexcept {}
+
+		auto allocate(size_t n) -> T* {
+			return static_cast<T*>(detail::arena_allocate(n * sizeof(T), alignof(T)));
+		}
+
+		auto deallocate(T* p, size_t n) noexcept -> void {
+			detail::arena_deallocate(p, n * sizeof(T), alignof(T));
+		}
+
+		template <typename U>
+		friend auto operator==(const arena_allocator& /*a*/, const arena_allocator<U>& /*b*/) noexcept -> bool {
+			return true;
+		}
+	};
+
+	using arena_string = std::basic_string<char, std::char_traits<char>, arena_allocator<char>>;
+
+	/*!
+		@brief	json document whose nodes and strings are allocated through arena_allocator
+	*/
+	using arena_json = nlohmann::basic_json<std::map, std::vector, arena_string, bool, std::int64_t, std::uint64_t,
+											double, arena_allocator>;
+
+	/*!
+		@brief	monotonic memory for short-lived documents, everything is freed at once by release() or
+				the destructor; no document allocated from it may be used afterwards
+	*/
+	class json_arena {
+	public:
+		explicit json_arena(size_t initial_size = 64 * 1024);
+
+		json_arena(const json_arena&) = delete;
+		auto operator=(const json_arena&) -> json_arena& = delete;
+
+		auto resource() -> std::pmr::memory_resource*;
+		auto release() -> void;
+
+	private:
+		std::pmr::monotonic_buffer_resource buffer;
+	};
+
+	/*!
+		@brief	routes the arena_json allocations of the current thread to an arena while alive, scopes
+				can be nested
+
+		e. g.	bestsens::json_arena arena;
+				{
+					const bestsens::json_arena_scope scope(arena);
+					auto request = bestsens::arena_json::parse(text);
+					...
+				}
+				arena.release();
+	*/
+	class json_arena_scope {
+	public:
+		explicit json_arena_scope(json_arena& arena);
+		explicit json_arena_scope(std::pmr::memory_resource* resource);
+		~json_arena_scope();
+
+		json_arena_scope(const json_arena_scope&) = delete;
+		auto operator=(const json_arena_scope&) -> json_arena_scope& = delete;
+
+		static auto current() -> std::pmr::memory_resource*;
+
+	private:
+		std::pmr::memory_resource* previous;
+	};
+}  // namespace bestsens
+
+#endif
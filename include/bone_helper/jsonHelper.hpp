@@ -10,111 +10,274 @@
 
 #include <syslog.h>
 
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <optional>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "nlohmann/json.hpp"
 
 namespace bestsens {
-	[[deprecated("use json::update instead")]]
+	/*!
+		@brief	any nlohmann::basic_json specialization, e. g. nlohmann::json or arena_json
+	*/
+	template <typename T>
+	concept basic_json_type = nlohmann::detail::is_basic_json<T>::value;
+
+	/*!
+		@brief	recursively patches target with patch in place, with the result merge_json produced by
+				flattening both documents: leaves of patch replace leaves of target, arrays are merged by
+				index and empty objects or arrays end up as null
+		@return	Returns false if a leaf of one document is a non-null value where the other has a
+				subtree; target is then left untouched, or replaced by patch if it is no object or array.
+
+		Unlike merge_json, objects with numeric keys stay objects and an object patch on an array is
+		treated as a conflict instead of being merged by index.
+	*/
+	auto merge_json_inplace(nlohmann::json& target, const nlohmann::json& patch) -> bool;
+
+	[[deprecated("use json::update or merge_json_inplace instead")]]
 	inline auto merge_json(const nlohmann::json &a, const nlohmann::json &b) -> nlohmann::json {
-		try {
-			nlohmann::json result = a.flatten();
-			nlohmann::json tmp = b.flatten();
-
-			for (auto it = tmp.begin(); it != tmp.end(); ++it) {
-				result[it.key()] = it.value();
-			}
+		nlohmann::json result = a;
 
-			return result.unflatten();
-		} catch (const nlohmann::json::exception& ia) {
-			syslog(LOG_WARNING, "error merging json: %s", ia.what());
+		if (!merge_json_inplace(result, b)) {
+			syslog(LOG_WARNING, "error merging json: conflicting types");
 		}
 
-		nlohmann::json return_value = a;
-		if (!return_value.is_object() && !return_value.is_array()) {
-			return_value = b;
+		return result;
+	}
+
+	namespace detail {
+		template <typename J, typename V>
+		auto is_array_of(const typename J::array_t& array, size_t size) -> bool {
+			return std::all_of(array.begin(), array.begin() + static_cast<std::ptrdiff_t>(size), [](const J& e) {
+				return e.template get_ptr<const V*>() != nullptr;
+			});
 		}
 
-		return return_value;
-	}
+		/*
+		 * fast path for arrays holding only floats or only signed integers on both sides, e. g. spectra:
+		 * one type check per array instead of a recursion per element
+		 */
+		template <typename J, typename Function>
+		auto arithmetic_merge_number_array(const J& from, J& to, Function operation) -> bool {
+			using float_t = typename J::number_float_t;
+			using integer_t = typename J::number_integer_t;
+
+			const auto& a = from.template get_ref<const typename J::array_t&>();
+			auto& b = to.template get_ref<typename J::array_t&>();
+			const auto size = std::min(a.size(), b.size());
+
+			if (is_array_of<J, float_t>(a, size) && is_array_of<J, float_t>(b, size)) {
+				for (size_t i = 0; i < size; ++i) {
+					auto& value = *b[i].template get_ptr<float_t*>();
+					value = static_cast<float_t>(operation(static_cast<double>(*a[i].template get_ptr<const float_t*>()),
+														   static_cast<double>(value)));
+				}
+
+				return true;
+			}
+
+			if (is_array_of<J, integer_t>(a, size) && is_array_of<J, integer_t>(b, size)) {
+				for (size_t i = 0; i < size; ++i) {
+					const auto result = operation(static_cast<long>(*a[i].template get_ptr<const integer_t*>()),
+												  static_cast<long>(*b[i].template get_ptr<const integer_t*>()));
+
+					// keep the element type unless the operation changes it (div)
+					if constexpr (std::is_integral_v<decltype(result)>) {
+						*b[i].template get_ptr<integer_t*>() = static_cast<integer_t>(result);
+					} else {
+						b[i] = result;
+					}
+				}
+
+				return true;
+			}
+
+			return false;
+		}
+	}  // namespace detail
 
 	// Modified JSON Merge Patch (RFC 7396 - section 2)
 	// to combine two json objects arithmetically
 	//
 	// e. g. from = { "data": 1 } and to = { "data": 2 } with operation ADD
 	// leads to { "data": 3 }
-	template <typename Function>
-	static auto arithmetic_merge_json(const nlohmann::json& from, nlohmann::json to, Function operation)
-		-> nlohmann::json {
+	//
+	// to is modified in place, every key of from has to exist in to (throws json::out_of_range
+	// otherwise, leaving to partially updated)
+	template <basic_json_type J, typename Function>
+	auto arithmetic_merge_json_inplace(const J& from, J& to, Function operation) -> void {
 		if (from.is_structured()) {
 			if (from.type() != to.type()) {
-				return to;	// for type incompatibility just return old value
+				return;	 // for type incompatibility keep the old value
 			}
 
-			size_t i{0};
-			for (auto it = from.cbegin(); it != from.cend(); ++it, ++i) {
-				if (from.is_object()) {
+			if (from.is_object()) {
+				for (auto it = from.cbegin(); it != from.cend(); ++it) {
 					if (!it.value().is_null()) {
-						to[it.key()] = arithmetic_merge_json(it.value(), to.at(it.key()), operation);
-					}
-				} else {
-					if (i >= to.size()) {
-						break;
+						arithmetic_merge_json_inplace(it.value(), to.at(it.key()), operation);
 					}
+				}
+			} else if (!detail::arithmetic_merge_number_array(from, to, operation)) {
+				const auto size = std::min(from.size(), to.size());
 
-					to[i] = arithmetic_merge_json(it.value(), to.at(i), operation);
+				for (size_t i = 0; i < size; ++i) {
+					arithmetic_merge_json_inplace(from[i], to[i], operation);
 				}
 			}
 
-			return to;
+			return;
 		}
 
 		// combine from and to if they are numbers
 		if (from.is_number() && to.is_number()) {
 			if (from.is_number_integer() && to.is_number_integer()) {
-				const auto a = from.get<long>();
-				const auto b = to.get<long>();
+				const auto a = from.template get<long>();
+				const auto b = to.template get<long>();
 
-				return nlohmann::json(operation(a, b));
+				to = operation(a, b);
 			} else {
-				const auto a = from.get<double>();
-				const auto b = to.get<double>();
+				const auto a = from.template get<double>();
+				const auto b = to.template get<double>();
 
-				return nlohmann::json(operation(a, b));
+				to = operation(a, b);
 			}
 		}
 
-		return to;	// from is neither a number nor an object, return old value
+		// from is neither a number nor an object, keep the old value
 	}
 
-	inline auto arithmetic_add_json(const nlohmann::json& from, const nlohmann::json& to) -> nlohmann::json {
-		return arithmetic_merge_json(from, to, [](auto a, auto b) { return a + b; });
+	template <basic_json_type J, typename Function>
+	static auto arithmetic_merge_json(const J& from, J to, Function operation) -> J {
+		arithmetic_merge_json_inplace(from, to, operation);
+		return to;
 	}
 
-	inline auto arithmetic_sub_json(const nlohmann::json& from, const nlohmann::json& to) -> nlohmann::json {
-		return arithmetic_merge_json(from, to, [](auto a, auto b) { return a - b; });
+	namespace detail {
+		struct arithmetic_div {
+			template <typename T>
+			auto operator()(T a, T b) const -> double {
+				if (b == 0) {
+					return static_cast<double>(a);
+				}
+
+				return static_cast<double>(a) / static_cast<double>(b);
+			}
+		};
+	}  // namespace detail
+
+	template <basic_json_type J>
+	auto arithmetic_add_json_inplace(const J& from, J& to) -> void {
+		arithmetic_merge_json_inplace(from, to, [](auto a, auto b) { return a + b; });
 	}
 
-	inline auto arithmetic_mul_json(const nlohmann::json& from, const nlohmann::json& to) -> nlohmann::json {
-		return arithmetic_merge_json(from, to, [](auto a, auto b) { return a * b; });
+	template <basic_json_type J>
+	auto arithmetic_sub_json_inplace(const J& from, J& to) -> void {
+		arithmetic_merge_json_inplace(from, to, [](auto a, auto b) { return a - b; });
 	}
 
-	inline auto arithmetic_div_json(const nlohmann::json& from, const nlohmann::json& to) -> nlohmann::json {
-		return arithmetic_merge_json(from, to, [](auto a, auto b) -> double {
-			if (b == 0) {
-				return static_cast<double>(a);
-			}
-			
-			try {
-				return static_cast<double>(a) / static_cast<double>(b);
-			} catch (...) {}
-			
-			return static_cast<double>(a);
-		});
+	template <basic_json_type J>
+	auto arithmetic_mul_json_inplace(const J& from, J& to) -> void {
+		arithmetic_merge_json_inplace(from, to, [](auto a, auto b) { return a * b; });
 	}
 
-	template <typename keytype>
-	auto value_ig_type(const nlohmann::json& input, const keytype& key, const std::string& default_value)
+	template <basic_json_type J>
+	auto arithmetic_div_json_inplace(const J& from, J& to) -> void {
+		arithmetic_merge_json_inplace(from, to, detail::arithmetic_div{});
+	}
+
+	template <basic_json_type J>
+	auto arithmetic_add_json(const J& from, const J& to) -> J {
+		auto result = to;
+		arithmetic_add_json_inplace(from, result);
+		return result;
+	}
+
+	template <basic_json_type J>
+	auto arithmetic_sub_json(const J& from, const J& to) -> J {
+		auto result = to;
+		arithmetic_sub_json_inplace(from, result);
+		return result;
+	}
+
+	template <basic_json_type J>
+	auto arithmetic_mul_json(const J& from, const J& to) -> J {
+		auto result = to;
+		arithmetic_mul_json_inplace(from, result);
+		return result;
+	}
+
+	template <basic_json_type J>
+	auto arithmetic_div_json(const J& from, const J& to) -> J {
+		auto result = to;
+		arithmetic_div_json_inplace(from, result);
+		return result;
+	}
+
+	/*!
+		@brief	sums json documents of a fixed shape, e. g. to compute running averages of statistics
+
+		The numeric leaves of the shape are compiled once into contiguous double and int64 arrays,
+		adding a sample only walks it alongside the compiled shape. Integer leaves of the shape stay
+		integers as long as only integers are added, like arithmetic_add_json a float sample turns
+		the sum into a float until reset(). Float leaves stay floats. Leaves missing in a sample and
+		members not part of the shape are ignored.
+	*/
+	class json_accumulator {
+	public:
+		explicit json_accumulator(nlohmann::json shape);
+
+		auto add(const nlohmann::json& sample) -> void;
+		auto add(const json_accumulator& other) -> void;
+		auto reset() -> void;
+
+		auto count() const -> size_t;
+		auto leaf_count() const -> size_t;
+		auto sum_of(const nlohmann::json::json_pointer& path) const -> std::optional<double>;
+
+		auto sum() const -> nlohmann::json;
+		auto mean() const -> nlohmann::json;
+
+	private:
+		enum class node_kind : uint8_t { object, array, real, integer };
+
+		struct node {
+			node_kind kind;
+			std::string key;  // member name inside the parent object
+			size_t end;		  // index behind the last node of the subtree
+			size_t slot;	  // index into reals or integers for leaves
+		};
+
+		auto compile(const nlohmann::json& j, std::string key, const nlohmann::json::json_pointer& path) -> void;
+		auto accumulate(size_t index, const nlohmann::json& value) -> void;
+		auto emit(nlohmann::json& j, size_t& real, size_t& integer, double divisor) const -> void;
+
+		nlohmann::json shape;
+		std::vector<node> nodes{};
+		std::unordered_map<std::string, size_t> path_index{};
+
+		std::vector<double> reals{};
+		std::vector<int64_t> integers{};
+		std::vector<double> integer_reals{};  // float samples added to integer leaves
+		std::vector<bool> promoted{};		   // integer leaves that received a float sample
+		size_t samples{0};
+	};
+
+	template <typename keytype, basic_json_type J>
+	auto value_ig_type(const J& input, const keytype& key, const std::string& default_value)
 		-> std::string {
 		if (!input.is_object()) {
 			return default_value;
@@ -122,56 +285,56 @@ namespace bestsens {
 
 		try {
 			return input.value(key, default_value);
-		} catch (const nlohmann::json::type_error& e) {
+		} catch (const typename J::type_error& e) {
 			return default_value;
 		}
 	}
 
-	template <typename keytype, typename T>
-	auto value_ig_type(const nlohmann::json& input, const keytype& key, const T& default_value) -> T {
+	template <typename keytype, typename T, basic_json_type J>
+	auto value_ig_type(const J& input, const keytype& key, const T& default_value) -> T {
 		if (!input.is_object()) {
 			return default_value;
 		}
 
 		try {
 			return input.value(key, default_value);
-		} catch (const nlohmann::json::type_error& e) {
+		} catch (const typename J::type_error& e) {
 			return default_value;
 		}
 	}
 
-	template <typename keytype>
-	auto is_json_number(const nlohmann::json& input, const keytype& key) -> bool {
+	template <typename keytype, basic_json_type J>
+	auto is_json_number(const J& input, const keytype& key) -> bool {
 		return (input.is_object() && input.contains(key) && input.at(key).is_number());
 	}
 
-	template <typename keytype>
-	auto is_json_array(const nlohmann::json& input, const keytype& key) -> bool {
+	template <typename keytype, basic_json_type J>
+	auto is_json_array(const J& input, const keytype& key) -> bool {
 		return (input.is_object() && input.contains(key) && input.at(key).is_array());
 	}
 
-	template <typename keytype>
-	auto is_json_string(const nlohmann::json& input, const keytype& key) -> bool {
+	template <typename keytype, basic_json_type J>
+	auto is_json_string(const J& input, const keytype& key) -> bool {
 		return (input.is_object() && input.contains(key) && input.at(key).is_string());
 	}
 
-	template <typename keytype>
-	auto is_json_bool(const nlohmann::json& input, const keytype& key) -> bool {
+	template <typename keytype, basic_json_type J>
+	auto is_json_bool(const J& input, const keytype& key) -> bool {
 		return (input.is_object() && input.contains(key) && input.at(key).is_boolean());
 	}
 
-	template <typename keytype>
-	auto is_json_object(const nlohmann::json& input, const keytype& key) -> bool {
+	template <typename keytype, basic_json_type J>
+	auto is_json_object(const J& input, const keytype& key) -> bool {
 		return (input.is_object() && input.contains(key) && input.at(key).is_object());
 	}
 
-	template <typename keytype>
-	auto is_json_node(const nlohmann::json& input, const keytype& key) -> bool {
+	template <typename keytype, basic_json_type J>
+	auto is_json_node(const J& input, const keytype& key) -> bool {
 		return (input.is_object() && input.contains(key) && !input.at(key).is_null());
 	}
 
-	template <typename keytype>
-	auto checkedUpdateFromJSON(const nlohmann::json& j, const keytype& name, int& value) -> bool {
+	template <typename keytype, basic_json_type J>
+	auto checkedUpdateFromJSON(const J& j, const keytype& name, int& value) -> bool {
 		if (is_json_number(j, name)) {
 			value = j.at(name).template get<int>();
 		} else {
@@ -181,8 +344,8 @@ namespace bestsens {
 		return true;
 	}
 
-	template <typename keytype>
-	auto checkedUpdateFromJSON(const nlohmann::json& j, const keytype& name, int& value, const int default_value)
+	template <typename keytype, basic_json_type J>
+	auto checkedUpdateFromJSON(const J& j, const keytype& name, int& value, const int default_value)
 		-> bool {
 		if (!checkedUpdateFromJSON(j, name, value)) {
 			value = default_value;
@@ -192,8 +355,8 @@ namespace bestsens {
 		return true;
 	}
 
-	template <typename keytype>
-	auto checkedUpdateFromJSON(const nlohmann::json& j, const keytype& name, double& value) -> bool {
+	template <typename keytype, basic_json_type J>
+	auto checkedUpdateFromJSON(const J& j, const keytype& name, double& value) -> bool {
 		if (is_json_number(j, name)) {
 			value = j.at(name).template get<double>();
 		} else {
@@ -203,8 +366,8 @@ namespace bestsens {
 		return true;
 	}
 
-	template <typename keytype>
-	auto checkedUpdateFromJSON(const nlohmann::json& j, const keytype& name, double& value, const double default_value)
+	template <typename keytype, basic_json_type J>
+	auto checkedUpdateFromJSON(const J& j, const keytype& name, double& value, const double default_value)
 		-> bool {
 		if (!checkedUpdateFromJSON(j, name, value)) {
 			value = default_value;
@@ -214,8 +377,8 @@ namespace bestsens {
 		return true;
 	}
 
-	template <typename keytype>
-	auto checkedUpdateFromJSON(const nlohmann::json& j, const keytype& name, bool& value) -> bool {
+	template <typename keytype, basic_json_type J>
+	auto checkedUpdateFromJSON(const J& j, const keytype& name, bool& value) -> bool {
 		if (is_json_bool(j, name)) {
 			value = j.at(name).template get<bool>();
 		} else {
@@ -225,8 +388,8 @@ namespace bestsens {
 		return true;
 	}
 
-	template <typename keytype>
-	auto checkedUpdateFromJSON(const nlohmann::json& j, const keytype& name, bool& value, const bool default_value)
+	template <typename keytype, basic_json_type J>
+	auto checkedUpdateFromJSON(const J& j, const keytype& name, bool& value, const bool default_value)
 		-> bool {
 		if (!checkedUpdateFromJSON(j, name, value)) {
 			value = default_value;
@@ -236,8 +399,8 @@ namespace bestsens {
 		return true;
 	}
 
-	template <typename keytype>
-	auto checkedUpdateFromJSON(const nlohmann::json& j, const keytype& name, std::string& value) -> bool {
+	template <typename keytype, basic_json_type J>
+	auto checkedUpdateFromJSON(const J& j, const keytype& name, std::string& value) -> bool {
 		if (is_json_string(j, name)) {
 			value = j.at(name).template get<std::string>();
 		} else {
@@ -247,8 +410,8 @@ namespace bestsens {
 		return true;
 	}
 
-	template <typename keytype>
-	auto checkedUpdateFromJSON(const nlohmann::json& j, const keytype& name, std::string& value,
+	template <typename keytype, basic_json_type J>
+	auto checkedUpdateFromJSON(const J& j, const keytype& name, std::string& value,
 									  const std::string& default_value) -> bool {
 		if (!checkedUpdateFromJSON(j, name, value)) {
 			value = default_value;
@@ -258,23 +421,346 @@ namespace bestsens {
 		return true;
 	}
 
-	inline auto get_filtered_values(const nlohmann::json& j, const std::vector<std::string>& filter) -> nlohmann::json {
-		if (filter.empty()) {
-			return j;
+	/*!
+		@brief	binds members of T to keys of a json object, replacing a series of checkedUpdateFromJSON calls
+
+		The fields are registered once, apply() then walks the members of the json object a single time
+		and looks every key up once (or looks up the bound keys if most members are not bound). Type
+		checks follow checkedUpdateFromJSON: numbers for arithmetic members, booleans for bool, strings
+		for std::string. A member whose key is missing or has the wrong type is set to its default if
+		one was given and left untouched otherwise.
+
+		e. g.	json_binding<config> binding;
+				binding.bind("port", &config::port, 6450).bind("name", &config::name);
+				binding.apply(j, cfg);
+	*/
+	template <typename T>
+	class json_binding {
+	public:
+		template <typename M>
+		auto bind(const std::string& key, M T::*member) -> json_binding& {
+			return this->add(key, member, std::optional<M>{});
+		}
+
+		template <typename M>
+		auto bind(const std::string& key, M T::*member, M default_value) -> json_binding& {
+			return this->add(key, member, std::optional<M>{std::move(default_value)});
 		}
 
-		nlohmann::json result;
+		/*!
+			@return	Returns the number of members that changed, unchanged members are not assigned.
+		*/
+		auto apply(const nlohmann::json& j, T& target) const -> size_t {
+			size_t changed{0};
+			std::vector<bool> seen(this->fields.size(), false);
+
+			if (j.is_object() && j.size() > 2 * this->fields.size()) {
+				// mostly members bound elsewhere, looking up the own keys is cheaper than walking them
+				for (size_t i = 0; i < this->fields.size(); ++i) {
+					const auto it = j.find(this->keys[i]);
 
-		for (const auto& e : j.items()) {
-			const auto it = std::find(filter.cbegin(), filter.cend(), e.key());
+					if (it != j.end()) {
+						seen[i] = true;
 
-			if (it != filter.end()) {
-				result[e.key()] = e.value();
+						if (this->fields[i](&it.value(), target)) {
+							++changed;
+						}
+					}
+				}
+			} else if (j.is_object()) {
+				for (auto it = j.cbegin(); it != j.cend(); ++it) {
+					const auto field = this->index.find(it.key());
+
+					if (field == this->index.end()) {
+						continue;
+					}
+
+					seen[field->second] = true;
+
+					if (this->fields[field->second](&it.value(), target)) {
+						++changed;
+					}
+				}
 			}
+
+			for (size_t i = 0; i < this->fields.size(); ++i) {
+				if (!seen[i] && this->fields[i](nullptr, target)) {
+					++changed;
+				}
+			}
+
+			return changed;
 		}
 
-		return result;
+		auto size() const -> size_t {
+			return this->fields.size();
+		}
+
+	private:
+		template <typename M>
+		auto add(const std::string& key, M T::*member, std::optional<M> default_value) -> json_binding& {
+			if (!this->index.emplace(key, this->fields.size()).second) {
+				throw std::invalid_argument("key " + key + " is already bound");
+			}
+
+			this->keys.push_back(key);
+
+			this->fields.emplace_back(
+				[member, default_value = std::move(default_value)](const nlohmann::json* j, T& target) -> bool {
+					auto& current = target.*member;
+
+					bool changed{false};
+					if (j != nullptr && read(*j, current, changed)) {
+						return changed;
+					}
+
+					if (default_value) {
+						return assign(current, *default_value);
+					}
+
+					return false;
+				});
+
+			return *this;
+		}
+
+		/*!
+			@return	Returns false if j has the wrong type for M.
+		*/
+		template <typename M>
+		static auto read(const nlohmann::json& j, M& current, bool& changed) -> bool {
+			if constexpr (std::is_same_v<M, bool>) {
+				if (!j.is_boolean()) {
+					return false;
+				}
+
+				changed = assign(current, j.get<bool>());
+			} else if constexpr (std::is_arithmetic_v<M>) {
+				if (!j.is_number()) {
+					return false;
+				}
+
+				changed = assign(current, j.get<M>());
+			} else if constexpr (std::is_same_v<M, std::string>) {
+				if (!j.is_string()) {
+					return false;
+				}
+
+				changed = assign(current, j.get_ref<const std::string&>());
+			} else {
+				try {
+					changed = assign(current, j.get<M>());
+				} catch (const nlohmann::json::exception&) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		template <typename M, typename V>
+		static auto assign(M& current, V&& value) -> bool {
+			if constexpr (std::equality_comparable_with<M, V>) {
+				if (current == value) {
+					return false;
+				}
+			}
+
+			current = std::forward<V>(value);
+			return true;
+		}
+
+		std::vector<std::function<bool(const nlohmann::json*, T&)>> fields{};
+		std::vector<std::string> keys{};
+		std::unordered_map<std::string, size_t> index{};
+	};
+
+	/*!
+		@brief	prebuilt set of keys for get_filtered_values, for filters that are applied repeatedly
+	*/
+	class json_key_filter {
+	public:
+		explicit json_key_filter(const std::vector<std::string>& keys) : keys(keys.begin(), keys.end()) {}
+
+		auto contains(const std::string& key) const -> bool {
+			return this->keys.contains(key);
+		}
+
+		auto empty() const -> bool {
+			return this->keys.empty();
+		}
+
+		auto size() const -> size_t {
+			return this->keys.size();
+		}
+
+		auto begin() const {
+			return this->keys.begin();
+		}
+
+		auto end() const {
+			return this->keys.end();
+		}
+
+	private:
+		std::unordered_set<std::string> keys;
+	};
+
+	/*!
+		@brief	returns the members of j listed in filter, null if none matched or j if filter is empty
+	*/
+	auto get_filtered_values(const nlohmann::json& j, const std::vector<std::string>& filter) -> nlohmann::json;
+	auto get_filtered_values(nlohmann::json&& j, const std::vector<std::string>& filter) -> nlohmann::json;
+	auto get_filtered_values(const nlohmann::json& j, const json_key_filter& filter) -> nlohmann::json;
+	auto get_filtered_values(nlohmann::json&& j, const json_key_filter& filter) -> nlohmann::json;
+
+	/*!
+		@brief	returns the values at the given json pointers in their nested position, e. g. the filter
+				"/payload/speed" keeps {"payload": {"speed": ...}}; array elements are padded with null
+	*/
+	auto get_filtered_values(const nlohmann::json& j, std::span<const nlohmann::json::json_pointer> filter)
+		-> nlohmann::json;
+	auto get_filtered_values(nlohmann::json&& j, std::span<const nlohmann::json::json_pointer> filter)
+		-> nlohmann::json;
+
+	/*!
+		@brief	computes the changes between consecutively published documents as JSON merge patch
+				(RFC 7386), to be applied on the receiving side with apply_json_delta
+
+		Only changed members are emitted, removed members as null; arrays are replaced as a whole.
+		Unchanged subtrees are compared without allocating, the previous document is updated by
+		applying the delta. Members with a null value can not be expressed in a merge patch and are
+		treated as absent.
+	*/
+	class json_delta_encoder {
+	public:
+		/*!
+			@return	Returns the merge patch from the previous to the current document, nullopt if
+					nothing changed; the first call returns the full document. Documents that are not
+					objects are sent as a whole when they change.
+		*/
+		auto encode(const nlohmann::json& current) -> std::optional<nlohmann::json>;
+
+		/*!
+			@brief	makes the next encode() return the full document, e. g. for a new subscriber; like
+					the first delta it has to be applied to an empty document
+		*/
+		auto reset() -> void;
+
+	private:
+		nlohmann::json previous{};
+		bool has_previous{false};
+	};
+
+	inline auto apply_json_delta(nlohmann::json& target, const nlohmann::json& delta) -> void {
+		target.merge_patch(delta);
 	}
+
+	enum class json_path_error { missing, type_mismatch };
+
+	/*!
+		@brief	json pointer split into keys and indices once, for paths looked up in every message
+
+		e. g. json_path("/payload/data/channels/3/rms").get<double>(j) instead of a chain of
+		is_json_object() checks followed by j["payload"]["data"]["channels"][3]["rms"]
+	*/
+	class json_path {
+	public:
+		/*!
+			@throw	json::parse_error if path is not a valid json pointer
+		*/
+		explicit json_path(const std::string& path);
+		explicit json_path(const nlohmann::json::json_pointer& path);
+
+		/*!
+			@return	Returns the node at the path, nullptr if it does not exist.
+		*/
+		template <basic_json_type J>
+		auto find(const J& j) const -> const J* {
+			const auto node = this->resolve(j);
+			return node ? *node : nullptr;
+		}
+
+		/*!
+			@return	Returns the value at the path, missing if the path does not exist or ends in null,
+					type_mismatch if a node on the path or the value has the wrong type.
+		*/
+		template <typename T, basic_json_type J>
+		auto get(const J& j) const -> std::expected<T, json_path_error> {
+			const auto node = this->resolve(j);
+
+			if (!node) {
+				return std::unexpected(node.error());
+			}
+
+			const J& value = **node;
+
+			if (value.is_null()) {
+				return std::unexpected(json_path_error::missing);
+			}
+
+			if constexpr (std::is_same_v<T, bool>) {
+				if (!value.is_boolean()) {
+					return std::unexpected(json_path_error::type_mismatch);
+				}
+			} else if constexpr (std::is_arithmetic_v<T>) {
+				if (!value.is_number()) {
+					return std::unexpected(json_path_error::type_mismatch);
+				}
+			} else if constexpr (std::is_constructible_v<std::string_view, const T&>) {
+				if (!value.is_string()) {
+					return std::unexpected(json_path_error::type_mismatch);
+				}
+			} else {
+				try {
+					return value.template get<T>();
+				} catch (const typename J::type_error&) {
+					return std::unexpected(json_path_error::type_mismatch);
+				}
+			}
+
+			return value.template get<T>();
+		}
+
+		auto size() const -> size_t;
+
+	private:
+		struct segment {
+			std::string key;
+			size_t index;  // npos if key is not an array index
+		};
+
+		template <basic_json_type J>
+		auto resolve(const J& j) const -> std::expected<const J*, json_path_error> {
+			const J* node = &j;
+
+			for (const auto& s : this->segments) {
+				if (node->is_object()) {
+					const auto it = node->find(std::string_view{s.key});
+
+					if (it == node->end()) {
+						return std::unexpected(json_path_error::missing);
+					}
+
+					node = &*it;
+				} else if (node->is_array()) {
+					if (s.index >= node->size()) {
+						return std::unexpected(json_path_error::missing);
+					}
+
+					node = &(*node)[s.index];
+				} else if (node->is_null()) {
+					return std::unexpected(json_path_error::missing);
+				} else {
+					return std::unexpected(json_path_error::type_mismatch);
+				}
+			}
+
+			return node;
+		}
+
+		std::vector<segment> segments{};
+	};
 } //namespace bestsens
 
 #endif
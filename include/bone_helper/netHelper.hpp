@@ -13,26 +13,384 @@
 #include <sys/time.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <mutex>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "boost/asio.hpp"
 #include "boost/asio/ip/tcp.hpp"
 #include "boost/asio/ssl.hpp"
+#include "boost/optional.hpp"
 #include "nlohmann/json.hpp"
 
 namespace bestsens {
+	/*!
+		@brief	response of a command sent with binary attachments enabled
+
+		Servers supporting it list the raw little-endian blobs following the envelope in its
+		"attachments" array ({"type": "f32", "size": <bytes>}) and reference them from the
+		payload as {"$attachment": <index>}. Servers that do not support it answer with a plain
+		envelope and no attachments.
+	*/
+	struct binary_response {
+		nlohmann::json envelope;
+		std::vector<std::vector<std::byte>> attachments;
+
+		template <typename T>
+		static constexpr auto type_name() -> std::string_view {
+			if constexpr (std::is_same_v<T, float>) {
+				return "f32";
+			} else if constexpr (std::is_same_v<T, double>) {
+				return "f64";
+			} else if constexpr (std::is_same_v<T, int8_t>) {
+				return "i8";
+			} else if constexpr (std::is_same_v<T, uint8_t>) {
+				return "u8";
+			} else if constexpr (std::is_same_v<T, int16_t>) {
+				return "i16";
+			} else if constexpr (std::is_same_v<T, uint16_t>) {
+				return "u16";
+			} else if constexpr (std::is_same_v<T, int32_t>) {
+				return "i32";
+			} else if constexpr (std::is_same_v<T, uint32_t>) {
+				return "u32";
+			} else if constexpr (std::is_same_v<T, int64_t>) {
+				return "i64";
+			} else {
+				static_assert(std::is_same_v<T, uint64_t>, "unsupported attachment type");
+				return "u64";
+			}
+		}
+
+		template <typename T>
+		auto attachment(size_t index) const -> std::span<const T> {
+			static_assert(std::endian::native == std::endian::little, "attachments are little-endian");
+
+			if (index >= this->attachments.size()) {
+				throw std::out_of_range("attachment index out of range");
+			}
+
+			if (this->envelope.at("attachments").at(index).value("type", "") != type_name<T>()) {
+				throw std::runtime_error("attachment type mismatch");
+			}
+
+			const auto& blob = this->attachments[index];
+
+			if (blob.size() % sizeof(T) != 0) {
+				throw std::runtime_error("attachment size mismatch");
+			}
+
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			return {reinterpret_cast<const T*>(blob.data()), blob.size() / sizeof(T)};
+		}
+
+		template <typename T>
+		auto attachment(const nlohmann::json& reference) const -> std::span<const T> {
+			return this->attachment<T>(reference.at("$attachment").get<size_t>());
+		}
+	};
+
+	/*!
+		@brief	command serialized once for repeated sends
+
+		The envelope is encoded on construction; set_payload() only re-encodes the payload and
+		splices it between the cached envelope prefix and suffix. Sending it does not touch the
+		DOM at all, which makes periodic polls allocation free on the send side.
+	*/
+	class prepared_command {
+	public:
+		prepared_command(std::string command, const nlohmann::json& payload = {}, int api_version = 0,
+						 bool use_msgpack = false);
+
+		auto set_payload(const nlohmann::json& payload) -> void;
+		auto set_encoded_payload(std::string_view payload) -> void;
+
+		auto command() const -> const std::string&;
+		auto is_msgpack() const -> bool;
+		auto encoded() const -> const std::string&;
+
+	private:
+		std::string name;
+		int api_version;
+		bool use_msgpack;
+
+		std::string request{};
+		size_t prefix_size{0};
+		bool has_payload{false};
+
+		auto encode_envelope(bool with_payload) -> void;
+		auto finish(std::string_view payload) -> void;
+	};
+
+	using subscription_callback = std::function<void(const nlohmann::json& frame)>;
+
+	/*!
+		@brief	maps a json key to a data member, see json_field_map
+	*/
+	template <typename C, typename M>
+	struct json_field {
+		std::string_view name;
+		M C::*member;
+	};
+
+	/*!
+		@brief	compile-time field map of a struct decoded by struct_sax, specialize it as
+
+			template <>
+			struct bestsens::json_field_map<status> {
+				static constexpr auto fields = std::make_tuple(
+					bestsens::json_field{"temperature", &status::temperature},
+					bestsens::json_field{"speed", &status::speed});
+			};
+	*/
+	template <typename T>
+	struct json_field_map;
+
+	template <typename T>
+	class struct_sax;
+
+	enum class command_priority : uint8_t { high = 0, normal = 1, bulk = 2 };
+
+	/*!
+		@brief	sets the priority of all commands the current thread sends while the scope is alive
+
+		Connections hand over to waiting commands in priority order, so a high priority command
+		waits at most for the command currently in flight. Transfers split into several commands
+		(e.g. paged waveform downloads) yield between them.
+	*/
+	class command_priority_scope {
+	public:
+		explicit command_priority_scope(command_priority priority);
+		~command_priority_scope();
+
+		command_priority_scope(const command_priority_scope&) = delete;
+		auto operator=(const command_priority_scope&) -> command_priority_scope& = delete;
+
+		static auto current() -> command_priority;
+
+	private:
+		command_priority previous;
+	};
+
+#ifdef ENABLE_NETHELPER_METRICS
+	inline constexpr bool metrics_enabled = true;
+#else
+	inline constexpr bool metrics_enabled = false;
+#endif
+
+	/*!
+		@brief	latency histogram with fixed bucket bounds in microseconds, the last bucket
+				counts everything above the largest bound
+	*/
+	struct latency_histogram {
+		static constexpr std::array<uint64_t, 12> bounds_us{50,	  100,	 250,	500,	1000,	2500,
+															5000, 10000, 25000, 100000, 250000, 1000000};
+
+		std::array<uint64_t, bounds_us.size() + 1> buckets{};
+		uint64_t count{0};
+		uint64_t sum_us{0};
+		uint64_t max_us{0};
+
+		auto record(uint64_t us) -> void {
+			const auto it = std::lower_bound(bounds_us.begin(), bounds_us.end(), us);
+			++this->buckets[static_cast<size_t>(it - bounds_us.begin())];
+			++this->count;
+			this->sum_us += us;
+			this->max_us = std::max(this->max_us, us);
+		}
+
+		auto to_json() const -> nlohmann::json {
+			return {{"bounds_us", bounds_us}, {"buckets", buckets}, {"count", count}, {"sum_us", sum_us}, {"max_us", max_us}};
+		}
+	};
+
+	/*!
+		@brief	metrics of a single connection as returned by netHelper::metrics()
+
+		Only collected if the library was built with ENABLE_NETHELPER_METRICS, otherwise all
+		values stay zero.
+	*/
+	struct metrics_snapshot {
+		latency_histogram connect{};
+		latency_histogram handshake{};
+		latency_histogram command{};
+		latency_histogram parse_json{};
+		latency_histogram parse_msgpack{};
+
+		uint64_t bytes_sent{0};
+		uint64_t bytes_received{0};
+		uint64_t timeouts{0};
+		uint64_t reconnects{0};
+
+		auto to_json() const -> nlohmann::json {
+			return {{"connect", connect.to_json()},
+					{"handshake", handshake.to_json()},
+					{"command", command.to_json()},
+					{"parse_json", parse_json.to_json()},
+					{"parse_msgpack", parse_msgpack.to_json()},
+					{"bytes_sent", bytes_sent},
+					{"bytes_received", bytes_received},
+					{"timeouts", timeouts},
+					{"reconnects", reconnects}};
+		}
+	};
+
 	namespace detail {
+		/*!
+			@brief	collects the metrics of a connection, compiles to nothing without ENABLE_NETHELPER_METRICS
+		*/
+		class metrics_recorder {
+		public:
+			using clock = std::chrono::steady_clock;
+
+			metrics_recorder() = default;
+			~metrics_recorder() = default;
+
+			metrics_recorder(const metrics_recorder&) = delete;
+			auto operator=(const metrics_recorder&) -> metrics_recorder& = delete;
+
+			metrics_recorder([[maybe_unused]] metrics_recorder&& src) noexcept {
+#ifdef ENABLE_NETHELPER_METRICS
+				const std::lock_guard<std::mutex> lock(src.mtx);
+				this->data = src.data;
+#endif
+			}
+
+			auto operator=([[maybe_unused]] metrics_recorder&& src) noexcept -> metrics_recorder& {
+#ifdef ENABLE_NETHELPER_METRICS
+				if (this != &src) {
+					const std::scoped_lock lock(this->mtx, src.mtx);
+					this->data = src.data;
+				}
+#endif
+				return *this;
+			}
+
+			static auto start() -> clock::time_point {
+#ifdef ENABLE_NETHELPER_METRICS
+				return clock::now();
+#else
+				return {};
+#endif
+			}
+
+			auto record([[maybe_unused]] latency_histogram metrics_snapshot::*histogram,
+						[[maybe_unused]] clock::time_point start) -> void {
+#ifdef ENABLE_NETHELPER_METRICS
+				const auto us = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+				const std::lock_guard<std::mutex> lock(this->mtx);
+				(this->data.*histogram).record(static_cast<uint64_t>(us));
+#endif
+			}
+
+			auto add([[maybe_unused]] uint64_t metrics_snapshot::*counter, [[maybe_unused]] uint64_t value = 1) -> void {
+#ifdef ENABLE_NETHELPER_METRICS
+				const std::lock_guard<std::mutex> lock(this->mtx);
+				this->data.*counter += value;
+#endif
+			}
+
+			auto snapshot() const -> metrics_snapshot {
+#ifdef ENABLE_NETHELPER_METRICS
+				const std::lock_guard<std::mutex> lock(this->mtx);
+
+				auto result = this->data;
+				result.reconnects = result.connect.count > 0 ? result.connect.count - 1 : 0;
+
+				return result;
+#else
+				return {};
+#endif
+			}
+
+#ifdef ENABLE_NETHELPER_METRICS
+		private:
+			mutable std::mutex mtx{};
+			metrics_snapshot data{};
+#endif
+		};
+
+		/*!
+			@brief	orders commands of several threads sharing a connection by priority and
+					optionally throttles normal and bulk commands with a token bucket
+		*/
+		class command_scheduler {
+		public:
+			command_scheduler() = default;
+			~command_scheduler() = default;
+
+			command_scheduler(const command_scheduler&) = delete;
+			auto operator=(const command_scheduler&) -> command_scheduler& = delete;
+
+			command_scheduler(command_scheduler&& src) noexcept;
+			auto operator=(command_scheduler&& src) noexcept -> command_scheduler&;
+
+			auto acquire(command_priority priority) -> void;
+			auto release() -> void;
+			auto queued() const -> size_t;
+
+			auto set_bandwidth_limit(size_t bytes_per_second, size_t burst) -> void;
+			auto account(size_t bytes) -> void;
+
+		private:
+			mutable std::mutex mtx{};
+			std::condition_variable cv{};
+
+			bool busy{false};
+			std::array<size_t, 3> waiting{};
+
+			size_t rate{0};
+			size_t burst{0};
+			double tokens{0.0};
+			std::chrono::steady_clock::time_point last_refill{};
+
+			auto refill() -> void;
+		};
+
+		/*!
+			@brief	holds the connection mutex after being scheduled with the priority of the calling thread
+		*/
+		class scheduled_lock {
+		public:
+			scheduled_lock(command_scheduler& scheduler, std::mutex& mtx);
+			~scheduled_lock();
+
+			scheduled_lock(const scheduled_lock&) = delete;
+			auto operator=(const scheduled_lock&) -> scheduled_lock& = delete;
+
+		private:
+			command_scheduler& scheduler;
+			std::unique_lock<std::mutex> lock{};
+		};
+
 		class netHelper_base {
 		public:
 			netHelper_base(std::string conn_target, std::string conn_port, bool use_msgpack = false,
 						   bool silent = false);
-			virtual ~netHelper_base() noexcept = default;
+			virtual ~netHelper_base() noexcept;
 
 			netHelper_base(const netHelper_base&) = delete;
-			// netHelper(netHelper&& src) noexcept;
+			auto operator=(const netHelper_base&) -> netHelper_base& = delete;
 
 			auto login(const std::string& user_name, const std::string& password, bool use_hash = true) -> int;
+			auto relogin() -> int;
 
 			auto is_logged_in() const -> int;
 
@@ -42,14 +400,44 @@ namespace bestsens {
 			auto send(const std::vector<uint8_t>& data) -> int;
 			auto send_command(const std::string& command, nlohmann::json& response, const nlohmann::json& payload = {},
 							  int api_version = 0) -> int;
+			auto send_command(const std::string& command, nlohmann::json::json_sax_t& sax,
+							  const nlohmann::json& payload = {}, int api_version = 0) -> int;
+			auto send_command(const std::string& command, binary_response& response, const nlohmann::json& payload = {},
+							  int api_version = 0) -> int;
 
 			auto getCommandReturnPayload(const std::string& command, const nlohmann::json& payload = {},
 										 int api_version = 0) -> nlohmann::json;
 
+			auto prepare(const std::string& command, const nlohmann::json& payload = {}, int api_version = 0) const
+				-> prepared_command;
+			auto send_command(const prepared_command& command, nlohmann::json& response) -> int;
+			auto getCommandReturnPayload(const prepared_command& command) -> nlohmann::json;
+
+			template <typename T>
+			auto getCommandReturnPayload(const std::string& command, const nlohmann::json& payload = {},
+										 int api_version = 0) -> T;
+
+			auto subscribe(const std::string& command, subscription_callback callback,
+						   const nlohmann::json& payload = {}, size_t queue_size = 64, bool drop_oldest = false)
+				-> nlohmann::json;
+			auto unsubscribe(const std::string& command = "unsubscribe") -> void;
+			auto is_subscribed() const -> bool;
+
 			auto set_timeout_ms(unsigned int timeout_ms) -> void;
+			auto set_deadline(std::chrono::steady_clock::time_point deadline) -> void;
+
+			auto enable_compression(size_t threshold = 1024) -> bool;
+			auto is_compression_enabled() const -> bool;
+
+			auto metrics() const -> metrics_snapshot;
+			auto set_bandwidth_limit(size_t bytes_per_second, size_t burst = 0) -> void;
 
 			auto get_mutex() -> std::mutex&;
 
+			static auto set_dns_cache_ttl(std::chrono::seconds ttl) -> void;
+			static auto get_dns_cache_ttl() -> std::chrono::seconds;
+			static auto clear_dns_cache() -> void;
+
 			static auto sha512(const std::string& input) -> std::string;
 			static auto getLastRawPosition(const unsigned char* str) -> unsigned int;
 			static auto getLastRawPosition(const char* str) -> unsigned int;
@@ -58,15 +446,56 @@ namespace bestsens {
 			virtual auto disconnect() -> void;
 			virtual auto send(const std::string& data) -> int;
 			virtual auto recv(void* buffer, size_t read_size) -> int;
+			virtual auto wait_readable(unsigned int timeout_ms) -> bool;
 
 		protected:
+			struct subscription;
+
+			/*
+			 * not noexcept: moving a connection with an active subscription throws std::logic_error
+			 * because the reader thread keeps using the old object, see move_source(); use the
+			 * netHelper wrapper where a subscribed connection has to be moved
+			 */
+			netHelper_base(netHelper_base&& src);
+			auto operator=(netHelper_base&& src) -> netHelper_base&;
+
+			static auto move_source(netHelper_base& src) -> netHelper_base&;
+
+			auto stop_subscription() -> std::unique_ptr<subscription>;
+			auto check_subscription() -> void;
+			auto send_request(const std::string& command, const nlohmann::json& payload, int api_version,
+							  bool binary_attachments = false) -> void;
+			auto send_encoded(const std::string& request) -> void;
+			auto record_transfer(uint64_t metrics_snapshot::*counter, size_t bytes) -> void;
+			auto send_command_buffered(const std::string& command, nlohmann::json::json_sax_t& sax,
+									   const nlohmann::json& payload, int api_version) -> int;
+			auto recv_response(nlohmann::json& response, metrics_recorder::clock::time_point start) -> int;
+			auto recv_binary_response(binary_response& response, metrics_recorder::clock::time_point start) -> int;
+			static auto return_payload_of(int retval, nlohmann::json& response) -> nlohmann::json;
+			auto recv_data_length() -> unsigned long;
+			auto send_compressed(const void* data, size_t size) -> bool;
+			auto decode_frame(std::vector<uint8_t>& data) const -> void;
+			auto recv_frame() -> std::vector<uint8_t>;
+			auto resolve(std::chrono::steady_clock::time_point deadline) -> std::vector<boost::asio::ip::tcp::endpoint>;
+			auto connect_socket(boost::asio::ip::tcp::socket& socket) -> void;
+			auto parse_frame(const std::vector<uint8_t>& data) -> nlohmann::json;
+			auto run_io(const boost::optional<boost::system::error_code>& result, unsigned int timeout_ms,
+						bool is_poll = false) -> boost::system::error_code;
+			auto deadline_after(unsigned int timeout_ms) const -> std::chrono::steady_clock::time_point;
+			virtual auto cancel_io() -> void;
+			virtual auto shutdown_socket() -> void;
+			auto drop_connection() -> void;
+
 			bool connected{false};
 			unsigned int timeout{10000};
+			std::chrono::steady_clock::time_point deadline{std::chrono::steady_clock::time_point::max()};
 			struct addrinfo remote {};
 
 			std::mutex sock_mtx{};
 
 			std::string user_name;
+			std::string password_hash;
+			std::string session_token;
 			std::string conn_target;
 			std::string conn_port;
 
@@ -74,38 +503,90 @@ namespace bestsens {
 			bool use_msgpack{false};
 			bool silent{false};
 
-			boost::asio::io_context io_context;
+			bool compression_active{false};
+			size_t compression_threshold{0};
+
+			std::unique_ptr<subscription> active_subscription;
+			std::mutex subscription_mtx{};
+
+			[[no_unique_address]] metrics_recorder stats{};
+			command_scheduler scheduler{};
+
+			// shared with the moved-from object, whose socket still refers to it until destroyed
+			std::shared_ptr<boost::asio::io_context> io_context{std::make_shared<boost::asio::io_context>()};
 		};
 
 		class netHelperTCP : public netHelper_base {
 		public:
 			netHelperTCP(std::string conn_target, std::string conn_port, bool use_msgpack = false, bool silent = false);
-			~netHelperTCP() noexcept override = default;
+			~netHelperTCP() noexcept override;
 			netHelperTCP(const netHelperTCP&) = delete;
-			netHelperTCP(netHelperTCP&& src) noexcept = delete;
+			netHelperTCP(netHelperTCP&& src);  // throws while subscribed, like netHelper_base
+			auto operator=(const netHelperTCP&) -> netHelperTCP& = delete;
+			auto operator=(netHelperTCP&& src) -> netHelperTCP&;
 
 			auto connect() -> int override;
 			auto disconnect() -> void override;
 
 			auto send(const std::string& data) -> int override;
 			auto recv(void* buffer, size_t read_size) -> int override;
+			auto wait_readable(unsigned int timeout_ms) -> bool override;
+
+		protected:
+			auto cancel_io() -> void override;
+			auto shutdown_socket() -> void override;
 
 		private:
 			boost::asio::ip::tcp::socket s;
 		};
 
+		/*!
+			@brief	connection to a local daemon over a unix domain stream socket, no TLS
+		*/
+		class netHelperUnix : public netHelper_base {
+		public:
+			explicit netHelperUnix(std::string socket_path, bool use_msgpack = false, bool silent = false);
+			~netHelperUnix() noexcept override;
+			netHelperUnix(const netHelperUnix&) = delete;
+			netHelperUnix(netHelperUnix&& src);  // throws while subscribed, like netHelper_base
+			auto operator=(const netHelperUnix&) -> netHelperUnix& = delete;
+			auto operator=(netHelperUnix&& src) -> netHelperUnix&;
+
+			auto connect() -> int override;
+			auto disconnect() -> void override;
+
+			auto send(const std::string& data) -> int override;
+			auto recv(void* buffer, size_t read_size) -> int override;
+			auto wait_readable(unsigned int timeout_ms) -> bool override;
+
+		protected:
+			auto cancel_io() -> void override;
+			auto shutdown_socket() -> void override;
+
+		private:
+			boost::asio::local::stream_protocol::socket s;
+		};
+
 		class netHelperSSL : public netHelper_base {
 		public:
 			netHelperSSL(std::string conn_target, std::string conn_port, bool use_msgpack = false, bool silent = false);
-			~netHelperSSL() noexcept override = default;
+			~netHelperSSL() noexcept override;
 			netHelperSSL(const netHelperSSL&) = delete;
-			netHelperSSL(netHelperSSL&& src) noexcept = delete;
+			netHelperSSL(netHelperSSL&& src);  // throws while subscribed, like netHelper_base
+			auto operator=(const netHelperSSL&) -> netHelperSSL& = delete;
+			// boost::asio::ssl::stream can be move constructed but not move assigned
+			auto operator=(netHelperSSL&& src) -> netHelperSSL& = delete;
 
 			auto connect() -> int override;
 			auto disconnect() -> void override;
 
 			auto send(const std::string& data) -> int override;
 			auto recv(void* buffer, size_t read_size) -> int override;
+			auto wait_readable(unsigned int timeout_ms) -> bool override;
+
+		protected:
+			auto cancel_io() -> void override;
+			auto shutdown_socket() -> void override;
 
 		private:
 			auto handshake() -> void;
@@ -121,13 +602,15 @@ namespace bestsens {
 				  bool use_ssl = false);
 		~netHelper() = default;
 
-		netHelper(netHelper&&) = default;
+		// only the pointer to the connection moves, so this never throws and keeps subscriptions running
+		netHelper(netHelper&&) noexcept = default;
 		netHelper(netHelper const& other) = delete;
 
-		auto operator=(netHelper&&) -> netHelper& = default;
+		auto operator=(netHelper&&) noexcept -> netHelper& = default;
 		auto operator=(netHelper const& other) -> netHelper& = delete;
 
 		auto login(const std::string& user_name, const std::string& password, bool use_hash = true) -> int;
+		auto relogin() -> int;
 
 		auto is_logged_in() const -> int;
 
@@ -137,15 +620,44 @@ namespace bestsens {
 		auto send(const std::vector<uint8_t>& data) -> int;
 		auto send_command(const std::string& command, nlohmann::json& response, const nlohmann::json& payload = {},
 						  int api_version = 0) -> int;
+		auto send_command(const std::string& command, nlohmann::json::json_sax_t& sax, const nlohmann::json& payload = {},
+						  int api_version = 0) -> int;
+		auto send_command(const std::string& command, binary_response& response, const nlohmann::json& payload = {},
+						  int api_version = 0) -> int;
 
 		auto getCommandReturnPayload(const std::string& command, const nlohmann::json& payload = {}, int api_version = 0)
 			-> nlohmann::json;
 
+		auto prepare(const std::string& command, const nlohmann::json& payload = {}, int api_version = 0) const
+			-> prepared_command;
+		auto send_command(const prepared_command& command, nlohmann::json& response) -> int;
+		auto getCommandReturnPayload(const prepared_command& command) -> nlohmann::json;
+
+		template <typename T>
+		auto getCommandReturnPayload(const std::string& command, const nlohmann::json& payload = {}, int api_version = 0)
+			-> T;
+
+		auto subscribe(const std::string& command, subscription_callback callback, const nlohmann::json& payload = {},
+					   size_t queue_size = 64, bool drop_oldest = false) -> nlohmann::json;
+		auto unsubscribe(const std::string& command = "unsubscribe") -> void;
+		auto is_subscribed() const -> bool;
+
 		[[deprecated]] auto set_timeout(unsigned int timeout) -> void;
 		auto set_timeout_ms(unsigned int timeout_ms) -> void;
+		auto set_deadline(std::chrono::steady_clock::time_point deadline) -> void;
+
+		auto enable_compression(size_t threshold = 1024) -> bool;
+		auto is_compression_enabled() const -> bool;
+
+		auto metrics() const -> metrics_snapshot;
+		auto set_bandwidth_limit(size_t bytes_per_second, size_t burst = 0) -> void;
 
 		auto get_mutex() -> std::mutex&;
 
+		static auto set_dns_cache_ttl(std::chrono::seconds ttl) -> void;
+		static auto get_dns_cache_ttl() -> std::chrono::seconds;
+		static auto clear_dns_cache() -> void;
+
 		static auto sha512(const std::string& input) -> std::string;
 		static auto getLastRawPosition(const unsigned char * str) -> unsigned int;
 		static auto getLastRawPosition(const char * str) -> unsigned int;
@@ -157,6 +669,391 @@ namespace bestsens {
 	private:
 		std::unique_ptr<detail::netHelper_base> ptr;
 	};
+
+	/*!
+		@brief	device addressed by fan_out(); login is skipped if user_name is empty
+	*/
+	struct fanout_endpoint {
+		std::string target;
+		std::string port;
+		bool use_ssl{false};
+		bool use_msgpack{false};
+		std::string user_name{};
+		std::string password{};
+	};
+
+	/*!
+		@brief	result of one endpoint of fan_out(), `index` refers to the endpoint list
+	*/
+	struct fanout_result {
+		size_t index{0};
+		nlohmann::json payload{};
+		std::string error{};
+
+		auto ok() const -> bool {
+			return this->error.empty();
+		}
+	};
+
+	struct fanout_options {
+		size_t concurrency{16};
+		unsigned int timeout_ms{2000};	// for connect, login and command of one endpoint together
+		int api_version{0};
+	};
+
+	using fanout_callback = std::function<void(const fanout_result& result)>;
+
+	/*!
+		@brief	sends `command` to all endpoints concurrently, at most `options.concurrency` at a time
+
+		Every endpoint gets its own connection, which has to be established, logged in and answered
+		within `options.timeout_ms`. Results are passed to `callback` in order of completion; calls
+		are serialized, so the callback needs no locking. Returns after all endpoints were handled.
+		If the callback throws, no further endpoints are started and the first exception is rethrown
+		once the running ones finished.
+	*/
+	auto fan_out(const std::vector<fanout_endpoint>& endpoints, const std::string& command,
+				 const fanout_callback& callback, const nlohmann::json& payload = {}, fanout_options options = {})
+		-> void;
+
+	/*!
+		@brief	SAX handler for send_command() that stores the numbers of the array found under `key`
+				directly in `target` without building a DOM; an "error" string is kept as well
+	*/
+	template <typename T>
+	class numeric_array_sax : public nlohmann::json::json_sax_t {
+	public:
+		numeric_array_sax(std::string key, std::vector<T>& target) : array_key(std::move(key)), target(target) {}
+
+		auto null() -> bool override {
+			this->consume_key();
+			return true;
+		}
+
+		auto boolean(bool /*val*/) -> bool override {
+			this->consume_key();
+			return true;
+		}
+
+		auto number_integer(number_integer_t val) -> bool override {
+			return this->add_number(val);
+		}
+
+		auto number_unsigned(number_unsigned_t val) -> bool override {
+			return this->add_number(val);
+		}
+
+		auto number_float(number_float_t val, const string_t& /*s*/) -> bool override {
+			return this->add_number(val);
+		}
+
+		auto string(string_t& val) -> bool override {
+			if (!this->capturing && this->consume_key() == "error") {
+				this->error_message = std::move(val);
+			}
+
+			return true;
+		}
+
+		auto binary(binary_t& /*val*/) -> bool override {
+			this->consume_key();
+			return true;
+		}
+
+		auto start_object(std::size_t /*elements*/) -> bool override {
+			this->consume_key();
+			++this->depth;
+			return true;
+		}
+
+		auto key(string_t& val) -> bool override {
+			this->last_key = std::move(val);
+			return true;
+		}
+
+		auto end_object() -> bool override {
+			--this->depth;
+			return true;
+		}
+
+		auto start_array(std::size_t elements) -> bool override {
+			++this->depth;
+
+			if (!this->capturing && this->consume_key() == this->array_key) {
+				this->capturing = true;
+				this->capture_depth = this->depth;
+				this->target.clear();
+
+				if (elements != std::numeric_limits<std::size_t>::max()) {
+					this->target.reserve(elements);
+				}
+			}
+
+			return true;
+		}
+
+		auto end_array() -> bool override {
+			if (this->capturing && this->depth == this->capture_depth) {
+				this->capturing = false;
+				this->array_found = true;
+			}
+
+			--this->depth;
+			return true;
+		}
+
+		auto parse_error(std::size_t /*position*/, const std::string& /*last_token*/,
+						 const nlohmann::json::exception& ex) -> bool override {
+			this->error_message = ex.what();
+			return false;
+		}
+
+		auto found() const -> bool {
+			return this->array_found;
+		}
+
+		auto error() const -> const std::string& {
+			return this->error_message;
+		}
+
+	private:
+		std::string array_key;
+		std::vector<T>& target;
+
+		std::string last_key{};
+		std::string error_message{};
+
+		int depth{0};
+		int capture_depth{0};
+		bool capturing{false};
+		bool array_found{false};
+
+		auto consume_key() -> std::string {
+			return std::exchange(this->last_key, {});
+		}
+
+		template <typename V>
+		auto add_number(V val) -> bool {
+			if (this->capturing && this->depth == this->capture_depth) {
+				this->target.push_back(static_cast<T>(val));
+			} else {
+				this->consume_key();
+			}
+
+			return true;
+		}
+	};
+
+	/*!
+		@brief	SAX handler that decodes the payload of a response directly into a struct described
+				by json_field_map<T>
+
+		Scalars are converted to arithmetic members, strings assigned to string members and
+		arrays appended to std::vector members. Unknown keys, nested objects and values that do
+		not fit the member type are skipped, members without a value keep their previous value.
+		An "error" string in the payload is kept as well.
+	*/
+	template <typename T>
+	class struct_sax : public nlohmann::json::json_sax_t {
+	public:
+		explicit struct_sax(T& target) : target(target) {}
+
+		auto null() -> bool override {
+			this->consume_key();
+			return true;
+		}
+
+		auto boolean(bool val) -> bool override {
+			return this->value(val);
+		}
+
+		auto number_integer(number_integer_t val) -> bool override {
+			return this->value(val);
+		}
+
+		auto number_unsigned(number_unsigned_t val) -> bool override {
+			return this->value(val);
+		}
+
+		auto number_float(number_float_t val, const string_t& /*s*/) -> bool override {
+			return this->value(val);
+		}
+
+		auto string(string_t& val) -> bool override {
+			if (this->in_payload() && this->last_key == "error") {
+				this->error_message = val;
+			}
+
+			return this->value(std::move(val));
+		}
+
+		auto binary(binary_t& /*val*/) -> bool override {
+			this->consume_key();
+			return true;
+		}
+
+		auto start_object(std::size_t /*elements*/) -> bool override {
+			const auto key = this->consume_key();
+			++this->depth;
+
+			if (this->depth == payload_depth && key == "payload") {
+				this->payload_open = true;
+			}
+
+			return true;
+		}
+
+		auto key(string_t& val) -> bool override {
+			this->last_key = std::move(val);
+			return true;
+		}
+
+		auto end_object() -> bool override {
+			if (this->depth == payload_depth) {
+				this->payload_open = false;
+			}
+
+			--this->depth;
+			return true;
+		}
+
+		auto start_array(std::size_t /*elements*/) -> bool override {
+			const auto key = this->consume_key();
+
+			if (this->in_payload()) {
+				this->visit_field(key, [&](auto& member) {
+					if constexpr (is_vector<std::remove_cvref_t<decltype(member)>>::value) {
+						member.clear();
+						this->array_key = key;
+						this->capturing = true;
+					}
+				});
+			}
+
+			++this->depth;
+			return true;
+		}
+
+		auto end_array() -> bool override {
+			if (this->capturing && this->depth == payload_depth + 1) {
+				this->capturing = false;
+			}
+
+			--this->depth;
+			return true;
+		}
+
+		auto parse_error(std::size_t /*position*/, const std::string& /*last_token*/,
+						 const nlohmann::json::exception& ex) -> bool override {
+			this->error_message = ex.what();
+			return false;
+		}
+
+		auto error() const -> const std::string& {
+			return this->error_message;
+		}
+
+	private:
+		static constexpr int payload_depth = 2;
+
+		template <typename V>
+		struct is_vector : std::false_type {};
+
+		template <typename V, typename A>
+		struct is_vector<std::vector<V, A>> : std::true_type {};
+
+		T& target;
+
+		std::string last_key{};
+		std::string array_key{};
+		std::string error_message{};
+
+		int depth{0};
+		bool payload_open{false};
+		bool capturing{false};
+
+		auto consume_key() -> std::string {
+			return std::exchange(this->last_key, {});
+		}
+
+		auto in_payload() const -> bool {
+			return this->payload_open && this->depth == payload_depth;
+		}
+
+		template <typename F>
+		auto visit_field(std::string_view name, F&& f) -> void {
+			std::apply(
+				[&](const auto&... field) {
+					((field.name == name ? (f(this->target.*(field.member)), true) : false) || ...);
+				},
+				json_field_map<T>::fields);
+		}
+
+		template <typename M, typename V>
+		static auto assign(M& member, V&& val) -> void {
+			if constexpr (std::is_same_v<std::remove_cvref_t<V>, std::string>) {
+				if constexpr (std::is_assignable_v<M&, std::string>) {
+					member = std::forward<V>(val);
+				}
+			} else if constexpr (std::is_arithmetic_v<M>) {
+				member = static_cast<M>(val);
+			}
+		}
+
+		template <typename V>
+		auto value(V&& val) -> bool {
+			const auto key = this->consume_key();
+
+			if (this->capturing && this->depth == payload_depth + 1) {
+				this->visit_field(this->array_key, [&](auto& member) {
+					if constexpr (is_vector<std::remove_cvref_t<decltype(member)>>::value) {
+						typename std::remove_cvref_t<decltype(member)>::value_type element{};
+						assign(element, std::forward<V>(val));
+						member.push_back(std::move(element));
+					}
+				});
+			} else if (this->in_payload()) {
+				this->visit_field(key, [&](auto& member) {
+					if constexpr (!is_vector<std::remove_cvref_t<decltype(member)>>::value) {
+						assign(member, std::forward<V>(val));
+					}
+				});
+			}
+
+			return true;
+		}
+	};
+
+	namespace detail {
+		/*!
+			@brief	sends a command and decodes the payload of the response into T without building a DOM
+			@return	Returns the decoded struct, throws if the response could not be parsed or contains an error.
+		*/
+		template <typename T>
+		auto netHelper_base::getCommandReturnPayload(const std::string& command, const nlohmann::json& payload,
+													 int api_version) -> T {
+			T result{};
+			struct_sax<T> sax(result);
+
+			const auto retval = this->send_command_buffered(command, sax, payload, api_version);
+
+			if (!sax.error().empty()) {
+				throw std::runtime_error(sax.error());
+			}
+
+			if (retval == 0) {
+				throw std::runtime_error("unknown error");
+			}
+
+			return result;
+		}
+	}  // namespace detail
+
+	template <typename T>
+	auto netHelper::getCommandReturnPayload(const std::string& command, const nlohmann::json& payload, int api_version)
+		-> T {
+		return this->ptr->template getCommandReturnPayload<T>(command, payload, api_version);
+	}
 } // namespace bestsens
 
 #endif /* NETHELPER_HPP_ */
@@ -0,0 +1,61 @@
+#include "bone_helper/jsonArena.hpp"
+
+#include <algorithm>
+
+namespace bestsens {
+	namespace {
+		thread_local std::pmr::memory_resource* current_resource{nullptr};
+
+		/*
+		 * the owning resource is stored in front of every block, padded to keep the requested alignment
+		 */
+		auto header_size(size_t alignment) -> size_t {
+			return std::max(alignment, alignof(std::max_align_t));
+		}
+	}  // namespace
+
+	namespace detail {
+		auto arena_allocate(size_t bytes, size_t alignment) -> void* {
+			auto* resource = json_arena_scope::current();
+			const auto header = header_size(alignment);
+
+			auto* base = static_cast<std::byte*>(resource->allocate(bytes + header, header));
+			*reinterpret_cast<std::pmr::memory_resource**>(base) = resource;
+
+			return base + header;
+		}
+
+		auto arena_deallocate(void* p, size_t bytes, size_t alignment) noexcept -> void {
+			const auto header = header_size(alignment);
+
+			auto* base = static_cast<std::byte*>(p) - header;
+			auto* resource = *reinterpret_cast<std::pmr::memory_resource**>(base);
+
+			resource->deallocate(base, bytes + header, header);
+		}
+	}  // namespace detail
+
+	json_arena::json_arena(size_t initial_size) : buffer(initial_size) {}
+
+	auto json_arena::resource() -> std::pmr::memory_resource* {
+		return &this->buffer;
+	}
+
+	auto json_arena::release() -> void {
+		this->buffer.release();
+	}
+
+	json_arena_scope::json_arena_scope(json_arena& arena) : json_arena_scope(arena.resource()) {}
+
+	json_arena_scope::json_arena_scope(std::pmr::memory_resource* resource) : previous(current_resource) {
+		current_resource = resource;
+	}
+
+	json_arena_scope::~json_arena_scope() {
+		current_resource = this->previous;
+	}
+
+	auto json_arena_scope::current() -> std::pmr::memory_resource* {
+		return current_resource != nullptr ? current_resource : std::pmr::get_default_resource();
+	}
+}  // namespace bestsens
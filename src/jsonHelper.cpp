@@ -0,0 +1,642 @@
+#include "bone_helper/jsonHelper.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace bestsens {
+	namespace {
+		/*
+		 * only objects are looked up by key, anything else keeps the iteration over items()
+		 */
+		template <typename J, typename Predicate>
+		auto filter_items(J&& j, Predicate contains) -> nlohmann::json {
+			nlohmann::json result;
+
+			for (auto&& e : j.items()) {
+				if (contains(e.key())) {
+					if constexpr (std::is_const_v<std::remove_reference_t<J>>) {
+						result[e.key()] = e.value();
+					} else {
+						result[e.key()] = std::move(e.value());
+					}
+				}
+			}
+
+			return result;
+		}
+
+		template <typename J, typename Keys>
+		auto filter_keys(J&& j, const Keys& keys) -> nlohmann::json {
+			nlohmann::json result;
+
+			for (const auto& key : keys) {
+				const auto it = j.find(key);
+
+				if (it == j.end()) {
+					continue;
+				}
+
+				if constexpr (std::is_const_v<std::remove_reference_t<J>>) {
+					result[key] = *it;
+				} else {
+					// erased, so a key listed twice does not pick up the moved-from value
+					result[key] = std::move(*it);
+					j.erase(it);
+				}
+			}
+
+			return result;
+		}
+
+		template <typename J>
+		auto filter_values(J&& j, const std::vector<std::string>& filter) -> nlohmann::json {
+			if (filter.empty()) {
+				return std::forward<J>(j);
+			}
+
+			if (!j.is_object()) {
+				return filter_items(j, [&filter](const std::string& key) {
+					return std::find(filter.cbegin(), filter.cend(), key) != filter.cend();
+				});
+			}
+
+			return filter_keys(j, filter);
+		}
+
+		template <typename J>
+		auto filter_values(J&& j, const json_key_filter& filter) -> nlohmann::json {
+			if (filter.empty()) {
+				return std::forward<J>(j);
+			}
+
+			if (!j.is_object()) {
+				return filter_items(j, [&filter](const std::string& key) { return filter.contains(key); });
+			}
+
+			// walk whichever side is smaller
+			if (filter.size() < j.size()) {
+				return filter_keys(j, filter);
+			}
+
+			nlohmann::json result;
+
+			for (auto it = j.begin(); it != j.end(); ++it) {
+				if (filter.contains(it.key())) {
+					if constexpr (std::is_const_v<std::remove_reference_t<J>>) {
+						result[it.key()] = it.value();
+					} else {
+						result[it.key()] = std::move(it.value());
+					}
+				}
+			}
+
+			return result;
+		}
+
+		auto is_prefix(const std::string& prefix, const std::string& path) -> bool {
+			return path.starts_with(prefix) && (path.size() == prefix.size() || path[prefix.size()] == '/');
+		}
+
+		/*
+		 * orders paths so that the children of a path directly follow it
+		 */
+		auto path_less(const std::string& a, const std::string& b) -> bool {
+			return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), [](char x, char y) {
+				const auto rank = [](char c) { return c == '/' ? 0 : static_cast<int>(static_cast<unsigned char>(c)) + 1; };
+				return rank(x) < rank(y);
+			});
+		}
+
+		/*
+		 * marks the entries of filter that are the same path, a parent or a child of another entry;
+		 * every path is built once, in sorted order the parents of a path are on a stack
+		 */
+		auto overlapping(std::span<const nlohmann::json::json_pointer> filter) -> std::vector<bool> {
+			std::vector<std::string> paths;
+			paths.reserve(filter.size());
+
+			for (const auto& pointer : filter) {
+				paths.push_back(pointer.to_string());
+			}
+
+			std::vector<size_t> order(filter.size());
+			std::iota(order.begin(), order.end(), size_t{0});
+			std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return path_less(paths[a], paths[b]); });
+
+			std::vector<bool> result(filter.size(), false);
+			std::vector<size_t> parents;
+
+			for (const auto i : order) {
+				while (!parents.empty() && !is_prefix(paths[parents.back()], paths[i])) {
+					parents.pop_back();
+				}
+
+				// the parents further down the stack were marked together with their child
+				if (!parents.empty()) {
+					result[i] = true;
+					result[parents.back()] = true;
+				}
+
+				parents.push_back(i);
+			}
+
+			return result;
+		}
+
+		template <typename J>
+		auto filter_pointers(J&& j, std::span<const nlohmann::json::json_pointer> filter) -> nlohmann::json {
+			if (filter.empty()) {
+				return std::forward<J>(j);
+			}
+
+			nlohmann::json result;
+
+			if constexpr (std::is_const_v<std::remove_reference_t<J>>) {
+				for (const auto& pointer : filter) {
+					if (j.contains(pointer)) {
+						result[pointer] = j.at(pointer);
+					}
+				}
+			} else {
+				// moving would leave a null behind for an overlapping pointer, these are copied
+				const auto shared = overlapping(filter);
+
+				for (size_t i = 0; i < filter.size(); ++i) {
+					const auto& pointer = filter[i];
+
+					if (!j.contains(pointer)) {
+						continue;
+					}
+
+					if (shared[i]) {
+						result[pointer] = j.at(pointer);
+					} else {
+						result[pointer] = std::move(j.at(pointer));
+					}
+				}
+			}
+
+			return result;
+		}
+
+		/*
+		 * merge_json_inplace follows the flattened representation, where empty objects and arrays are
+		 * null leaves and a path can not be both a non-null leaf and the parent of other leaves
+		 */
+		auto is_leaf(const nlohmann::json& j) -> bool {
+			return !j.is_structured() || j.empty();
+		}
+
+		auto is_null_leaf(const nlohmann::json& j) -> bool {
+			return j.is_null() || (j.is_structured() && j.empty());
+		}
+
+		auto mergeable(const nlohmann::json& target, const nlohmann::json& patch) -> bool {
+			if (is_leaf(patch)) {
+				return is_leaf(target) || is_null_leaf(patch);
+			}
+
+			if (is_leaf(target)) {
+				return is_null_leaf(target);
+			}
+
+			if (target.type() != patch.type()) {
+				return false;
+			}
+
+			if (patch.is_object()) {
+				for (auto it = patch.cbegin(); it != patch.cend(); ++it) {
+					const auto child = target.find(it.key());
+
+					if (child != target.end() && !mergeable(*child, it.value())) {
+						return false;
+					}
+				}
+			} else {
+				const auto size = std::min(target.size(), patch.size());
+
+				for (size_t i = 0; i < size; ++i) {
+					if (!mergeable(target[i], patch[i])) {
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		auto merge(nlohmann::json& target, const nlohmann::json& patch) -> void {
+			if (is_leaf(patch)) {
+				// a null leaf on top of a subtree leaves the subtree untouched
+				if (is_leaf(target)) {
+					target = patch.is_structured() ? nlohmann::json() : patch;
+				}
+
+				return;
+			}
+
+			if (is_leaf(target)) {
+				target = nlohmann::json(patch.type());
+			}
+
+			if (patch.is_object()) {
+				for (auto it = patch.cbegin(); it != patch.cend(); ++it) {
+					merge(target[it.key()], it.value());
+				}
+			} else {
+				for (size_t i = 0; i < patch.size(); ++i) {
+					if (i >= target.size()) {
+						target.push_back(nullptr);
+					}
+
+					merge(target[i], patch[i]);
+				}
+			}
+		}
+
+		auto null_empty_containers(nlohmann::json& j) -> void {
+			if (!j.is_structured()) {
+				return;
+			}
+
+			if (j.empty()) {
+				j = nullptr;
+				return;
+			}
+
+			for (auto& child : j) {
+				null_empty_containers(child);
+			}
+		}
+
+		/*
+		 * merge patch turning previous into current, both objects; members are matched by merging
+		 * the sorted member lists
+		 */
+		auto diff_object(const nlohmann::json& previous, const nlohmann::json& current) -> nlohmann::json {
+			auto delta = nlohmann::json::object();
+
+			auto prev = previous.cbegin();
+			auto cur = current.cbegin();
+
+			while (prev != previous.cend() || cur != current.cend()) {
+				if (cur == current.cend() || (prev != previous.cend() && prev.key() < cur.key())) {
+					delta[prev.key()] = nullptr;
+					++prev;
+					continue;
+				}
+
+				if (prev == previous.cend() || cur.key() < prev.key()) {
+					if (!cur.value().is_null()) {
+						delta[cur.key()] = cur.value();
+					}
+
+					++cur;
+					continue;
+				}
+
+				const auto& p = prev.value();
+				const auto& c = cur.value();
+
+				// comparing first does not allocate, only changed subtrees are descended into
+				if (c.is_null()) {
+					delta[cur.key()] = nullptr;
+				} else if (p.is_object() && c.is_object()) {
+					// differs as well if only c has null members, the nested delta is empty then
+					if (p != c) {
+						auto nested = diff_object(p, c);
+
+						if (!nested.empty()) {
+							delta[cur.key()] = std::move(nested);
+						}
+					}
+				} else if (p != c) {
+					delta[cur.key()] = c;
+				}
+
+				++prev;
+				++cur;
+			}
+
+			return delta;
+		}
+	}  // namespace
+
+	json_accumulator::json_accumulator(nlohmann::json shape) : shape(std::move(shape)) {
+		this->compile(this->shape, {}, nlohmann::json::json_pointer());
+	}
+
+	/*!
+		@brief	flattens the shape into nodes in iteration order, the subtree of a node follows it directly
+	*/
+	auto json_accumulator::compile(const nlohmann::json& j, std::string key, const nlohmann::json::json_pointer& path)
+		-> void {
+		const auto index = this->nodes.size();
+
+		if (j.is_number_integer()) {
+			this->nodes.push_back({node_kind::integer, std::move(key), index + 1, this->integers.size()});
+			this->integers.push_back(0);
+			this->integer_reals.push_back(0.0);
+			this->promoted.push_back(false);
+		} else if (j.is_number()) {
+			this->nodes.push_back({node_kind::real, std::move(key), index + 1, this->reals.size()});
+			this->reals.push_back(0.0);
+		} else if (j.is_object()) {
+			this->nodes.push_back({node_kind::object, std::move(key), 0, 0});
+
+			for (auto it = j.cbegin(); it != j.cend(); ++it) {
+				this->compile(it.value(), it.key(), path / it.key());
+			}
+		} else if (j.is_array()) {
+			this->nodes.push_back({node_kind::array, std::move(key), 0, 0});
+
+			for (size_t i = 0; i < j.size(); ++i) {
+				this->compile(j[i], {}, path / i);
+			}
+		} else {
+			return;	 // strings, booleans and null are passed through unchanged
+		}
+
+		this->nodes[index].end = this->nodes.size();
+		this->path_index.emplace(path.to_string(), index);
+	}
+
+	auto json_accumulator::add(const nlohmann::json& sample) -> void {
+		if (!this->nodes.empty()) {
+			this->accumulate(0, sample);
+		}
+
+		++this->samples;
+	}
+
+	/*!
+		@brief	adds the sums of an accumulator compiled from the same shape, e. g. of another thread
+	*/
+	auto json_accumulator::add(const json_accumulator& other) -> void {
+		if (other.reals.size() != this->reals.size() || other.integers.size() != this->integers.size()) {
+			throw std::invalid_argument("accumulators have different shapes");
+		}
+
+		for (size_t i = 0; i < this->reals.size(); ++i) {
+			this->reals[i] += other.reals[i];
+		}
+
+		for (size_t i = 0; i < this->integers.size(); ++i) {
+			this->integers[i] += other.integers[i];
+			this->integer_reals[i] += other.integer_reals[i];
+			this->promoted[i] = this->promoted[i] || other.promoted[i];
+		}
+
+		this->samples += other.samples;
+	}
+
+	auto json_accumulator::reset() -> void {
+		std::fill(this->reals.begin(), this->reals.end(), 0.0);
+		std::fill(this->integers.begin(), this->integers.end(), 0);
+		std::fill(this->integer_reals.begin(), this->integer_reals.end(), 0.0);
+		std::fill(this->promoted.begin(), this->promoted.end(), false);
+		this->samples = 0;
+	}
+
+	auto json_accumulator::count() const -> size_t {
+		return this->samples;
+	}
+
+	auto json_accumulator::leaf_count() const -> size_t {
+		return this->reals.size() + this->integers.size();
+	}
+
+	auto json_accumulator::sum_of(const nlohmann::json::json_pointer& path) const -> std::optional<double> {
+		const auto it = this->path_index.find(path.to_string());
+
+		if (it == this->path_index.end()) {
+			return std::nullopt;
+		}
+
+		const auto& n = this->nodes[it->second];
+
+		switch (n.kind) {
+			case node_kind::real:
+				return this->reals[n.slot];
+			case node_kind::integer:
+				return static_cast<double>(this->integers[n.slot]) + this->integer_reals[n.slot];
+			default:
+				return std::nullopt;
+		}
+	}
+
+	/*!
+		@brief	walks value alongside the node at index; object members are matched by merging the
+				sorted member lists, so a sample of the same shape needs no lookups
+	*/
+	auto json_accumulator::accumulate(size_t index, const nlohmann::json& value) -> void {
+		const auto& n = this->nodes[index];
+
+		switch (n.kind) {
+			case node_kind::real:
+				if (value.is_number()) {
+					this->reals[n.slot] += value.get<double>();
+				}
+				break;
+			case node_kind::integer:
+				if (value.is_number_integer()) {
+					this->integers[n.slot] += value.get<int64_t>();
+				} else if (value.is_number_float()) {
+					this->integer_reals[n.slot] += value.get<double>();
+					this->promoted[n.slot] = true;
+				}
+				break;
+			case node_kind::object: {
+				if (!value.is_object()) {
+					break;
+				}
+
+				auto it = value.cbegin();
+				const auto last = value.cend();
+
+				for (auto child = index + 1; child < n.end; child = this->nodes[child].end) {
+					const auto& key = this->nodes[child].key;
+
+					while (it != last && it.key() < key) {
+						++it;
+					}
+
+					if (it != last && it.key() == key) {
+						this->accumulate(child, it.value());
+					}
+				}
+				break;
+			}
+			case node_kind::array: {
+				if (!value.is_array()) {
+					break;
+				}
+
+				size_t i{0};
+				for (auto child = index + 1; child < n.end && i < value.size(); child = this->nodes[child].end, ++i) {
+					this->accumulate(child, value[i]);
+				}
+				break;
+			}
+		}
+	}
+
+	/*!
+		@return	Returns the shape with every numeric leaf replaced by its sum.
+	*/
+	auto json_accumulator::sum() const -> nlohmann::json {
+		auto result = this->shape;
+
+		size_t real{0};
+		size_t integer{0};
+		this->emit(result, real, integer, 0.0);
+
+		return result;
+	}
+
+	/*!
+		@return	Returns the shape with every numeric leaf replaced by its average as float; without
+				samples the (zero) sums are returned.
+	*/
+	auto json_accumulator::mean() const -> nlohmann::json {
+		auto result = this->shape;
+
+		size_t real{0};
+		size_t integer{0};
+		this->emit(result, real, integer, this->samples > 0 ? static_cast<double>(this->samples) : 1.0);
+
+		return result;
+	}
+
+	/*!
+		@brief	writes the accumulated values back in compile order, a divisor of 0 keeps integer sums
+	*/
+	auto json_accumulator::emit(nlohmann::json& j, size_t& real, size_t& integer, double divisor) const -> void {
+		if (j.is_number_integer()) {
+			const auto slot = integer++;
+			const auto value = static_cast<double>(this->integers[slot]) + this->integer_reals[slot];
+
+			if (divisor > 0.0) {
+				j = value / divisor;
+			} else if (this->promoted[slot]) {
+				j = value;
+			} else {
+				j = this->integers[slot];
+			}
+		} else if (j.is_number()) {
+			j = divisor > 0.0 ? this->reals[real++] / divisor : this->reals[real++];
+		} else if (j.is_structured()) {
+			for (auto& child : j) {
+				this->emit(child, real, integer, divisor);
+			}
+		}
+	}
+
+	auto merge_json_inplace(nlohmann::json& target, const nlohmann::json& patch) -> bool {
+		if (!mergeable(target, patch)) {
+			if (!target.is_structured()) {
+				target = patch;
+			}
+
+			return false;
+		}
+
+		merge(target, patch);
+		null_empty_containers(target);
+
+		return true;
+	}
+
+	auto get_filtered_values(const nlohmann::json& j, const std::vector<std::string>& filter) -> nlohmann::json {
+		return filter_values(j, filter);
+	}
+
+	auto get_filtered_values(nlohmann::json&& j, const std::vector<std::string>& filter) -> nlohmann::json {
+		return filter_values(std::move(j), filter);
+	}
+
+	auto get_filtered_values(const nlohmann::json& j, const json_key_filter& filter) -> nlohmann::json {
+		return filter_values(j, filter);
+	}
+
+	auto get_filtered_values(nlohmann::json&& j, const json_key_filter& filter) -> nlohmann::json {
+		return filter_values(std::move(j), filter);
+	}
+
+	auto get_filtered_values(const nlohmann::json& j, std::span<const nlohmann::json::json_pointer> filter)
+		-> nlohmann::json {
+		return filter_pointers(j, filter);
+	}
+
+	auto get_filtered_values(nlohmann::json&& j, std::span<const nlohmann::json::json_pointer> filter)
+		-> nlohmann::json {
+		return filter_pointers(std::move(j), filter);
+	}
+
+	auto json_delta_encoder::encode(const nlohmann::json& current) -> std::optional<nlohmann::json> {
+		if (!this->has_previous) {
+			// the same patch the receiver applies, so both sides drop null members alike
+			this->previous = nullptr;
+			this->previous.merge_patch(current);
+			this->has_previous = true;
+
+			return current;
+		}
+
+		nlohmann::json delta;
+
+		if (this->previous.is_object() && current.is_object()) {
+			delta = diff_object(this->previous, current);
+
+			if (delta.empty()) {
+				return std::nullopt;
+			}
+		} else if (this->previous == current) {
+			// an empty patch would turn a non-object document into an empty object
+			return std::nullopt;
+		} else {
+			delta = current;
+		}
+
+		this->previous.merge_patch(delta);
+		return delta;
+	}
+
+	auto json_delta_encoder::reset() -> void {
+		this->previous = nullptr;
+		this->has_previous = false;
+	}
+
+	json_path::json_path(const std::string& path) : json_path(nlohmann::json::json_pointer(path)) {}
+
+	json_path::json_path(const nlohmann::json::json_pointer& path) {
+		auto remaining = path;
+
+		while (!remaining.empty()) {
+			auto key = remaining.back();
+			remaining.pop_back();
+
+			// array indices as defined by RFC 6901, without leading zeros
+			const bool is_index = !key.empty() && (key == "0" || key.front() != '0') &&
+								  std::all_of(key.begin(), key.end(), [](char c) { return c >= '0' && c <= '9'; });
+
+			size_t index = std::string::npos;
+			if (is_index && key.size() < 19) {
+				index = static_cast<size_t>(std::stoull(key));
+			}
+
+			this->segments.push_back({std::move(key), index});
+		}
+
+		std::reverse(this->segments.begin(), this->segments.end());
+	}
+
+	auto json_path::size() const -> size_t {
+		return this->segments.size();
+	}
+}  // namespace bestsens
@@ -14,11 +14,26 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <cstring>
+#include <iterator>
+#include <map>
+#include <memory>
 #include <exception>
+#include <functional>
 #include <mutex>
+#include <numeric>
+#include <set>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "bone_helper/jsonHelper.hpp"
 #include "bone_helper/system_helper.hpp"
@@ -29,19 +44,79 @@
 #include "boost/asio/ssl/context.hpp"
 #include "boost/asio/ssl/stream.hpp"
 #include "boost/asio/ssl/verify_mode.hpp"
-#include "boost/date_time/posix_time/posix_time_duration.hpp"
 #include "boost/optional.hpp"
 #include "fmt/format.h"
 #include "fmt/ranges.h"
 #include "nlohmann/json.hpp"
 #include "spdlog/spdlog.h"
 
+#ifdef ENABLE_ZSTD_COMPRESSION
+#include <zstd.h>
+#endif
+
 namespace bestsens {
 	using json = nlohmann::json;
 
 	namespace detail {
 		using boost::asio::ip::tcp;
 
+		namespace {
+			constexpr std::string_view request_delimiter = "\r\n";
+			constexpr std::array<uint8_t, 4> zstd_magic{0x28, 0xB5, 0x2F, 0xFD};
+
+			auto is_zstd_frame(const void* data, size_t size) -> bool {
+				return size >= zstd_magic.size() && std::memcmp(data, zstd_magic.data(), zstd_magic.size()) == 0;
+			}
+
+#ifdef ENABLE_ZSTD_COMPRESSION
+			struct zstd_dctx_deleter {
+				auto operator()(ZSTD_DCtx* dctx) const -> void {
+					ZSTD_freeDCtx(dctx);
+				}
+			};
+
+			using zstd_dctx_ptr = std::unique_ptr<ZSTD_DCtx, zstd_dctx_deleter>;
+
+			auto compress_zstd(const void* data, size_t size) -> std::string {
+				std::string result(ZSTD_compressBound(size), '\0');
+
+				const auto t = ZSTD_compress(result.data(), result.size(), data, size, 1);
+
+				if (ZSTD_isError(t) != 0u) {
+					throw std::runtime_error(fmt::format("compression failed: {}", ZSTD_getErrorName(t)));
+				}
+
+				result.resize(t);
+				return result;
+			}
+
+			auto decompress_zstd(const std::vector<uint8_t>& data) -> std::vector<uint8_t> {
+				const zstd_dctx_ptr dctx(ZSTD_createDCtx());
+				std::vector<uint8_t> result;
+				std::vector<uint8_t> chunk(ZSTD_DStreamOutSize());
+
+				ZSTD_inBuffer in{data.data(), data.size(), 0};
+
+				while (true) {
+					ZSTD_outBuffer out{chunk.data(), chunk.size(), 0};
+					const auto t = ZSTD_decompressStream(dctx.get(), &out, &in);
+
+					if (ZSTD_isError(t) != 0u) {
+						throw std::runtime_error(fmt::format("decompression failed: {}", ZSTD_getErrorName(t)));
+					}
+
+					result.insert(result.end(), chunk.begin(), chunk.begin() + static_cast<long>(out.pos));
+
+					if (t == 0 || (in.pos == in.size && out.pos == 0)) {
+						break;
+					}
+				}
+
+				return result;
+			}
+#endif
+		}  // namespace
+
 		netHelper_base::netHelper_base(std::string conn_target, std::string conn_port, bool use_msgpack, bool silent)
 			: conn_target(std::move(conn_target)),
 			conn_port(std::move(conn_port)),
@@ -50,24 +125,197 @@ namespace bestsens {
 			this->set_timeout_ms(this->timeout);
 		}
 
-		// netHelper_base::netHelper_base(netHelper_base&& src) noexcept : use_ssl(src.use_ssl) {
-		// 	const std::lock_guard<std::mutex> lock_src(src.sock_mtx);
+		netHelper_base::~netHelper_base() noexcept = default;
+
+		/*!
+			@brief	takes over the connection state of src, which is left disconnected and may only be
+					destroyed or assigned to; src must not be used by another thread meanwhile
+		*/
+		netHelper_base::netHelper_base(netHelper_base&& src)
+			: connected(std::exchange(move_source(src).connected, false)),
+			timeout(src.timeout),
+			deadline(src.deadline),
+			remote(src.remote),
+			user_name(std::move(src.user_name)),
+			password_hash(std::move(src.password_hash)),
+			session_token(std::move(src.session_token)),
+			conn_target(std::move(src.conn_target)),
+			conn_port(std::move(src.conn_port)),
+			user_level(std::exchange(src.user_level, 0)),
+			use_msgpack(src.use_msgpack),
+			silent(src.silent),
+			compression_active(std::exchange(src.compression_active, false)),
+			compression_threshold(src.compression_threshold),
+			stats(std::move(src.stats)),
+			scheduler(std::move(src.scheduler)),
+			io_context(src.io_context) {}
+
+		/*!
+			@brief	drops the own connection state and takes over the one of src; the derived classes
+					transfer the socket afterwards
+		*/
+		auto netHelper_base::operator=(netHelper_base&& src) -> netHelper_base& {
+			if (this == &move_source(src)) {
+				return *this;
+			}
+
+			this->stop_subscription();
+
+			this->connected = std::exchange(src.connected, false);
+			this->timeout = src.timeout;
+			this->deadline = src.deadline;
+			this->remote = src.remote;
+			this->user_name = std::move(src.user_name);
+			this->password_hash = std::move(src.password_hash);
+			this->session_token = std::move(src.session_token);
+			this->conn_target = std::move(src.conn_target);
+			this->conn_port = std::move(src.conn_port);
+			this->user_level = std::exchange(src.user_level, 0);
+			this->use_msgpack = src.use_msgpack;
+			this->silent = src.silent;
+			this->compression_active = std::exchange(src.compression_active, false);
+			this->compression_threshold = src.compression_threshold;
+			this->stats = std::move(src.stats);
+			this->scheduler = std::move(src.scheduler);
+			this->io_context = src.io_context;
+
+			return *this;
+		}
+
+		/*!
+			@brief	the reader thread of a subscription is bound to the object, so it can not be moved
+		*/
+		auto netHelper_base::move_source(netHelper_base& src) -> netHelper_base& {
+			src.check_subscription();
+			return src;
+		}
+
+		/*!
+			@brief	waits until the connection is free and no command of higher priority is waiting;
+					normal and bulk commands additionally wait while the bandwidth budget is exhausted
+		*/
+		auto command_scheduler::acquire(command_priority priority) -> void {
+			const auto index = static_cast<size_t>(priority);
+
+			std::unique_lock<std::mutex> lock(this->mtx);
+			++this->waiting[index];
+
+			while (true) {
+				this->refill();
+
+				const auto higher_waiting =
+					std::any_of(this->waiting.begin(), this->waiting.begin() + static_cast<long>(index),
+								[](size_t n) { return n > 0; });
+				const auto throttled = priority != command_priority::high && this->rate > 0 && this->tokens < 0;
+
+				if (!this->busy && !higher_waiting && !throttled) {
+					break;
+				}
+
+				if (throttled) {
+					const auto wait = std::chrono::duration<double>(-this->tokens / static_cast<double>(this->rate));
+					this->cv.wait_for(lock, std::chrono::duration_cast<std::chrono::microseconds>(wait) +
+												std::chrono::microseconds(1));
+				} else {
+					this->cv.wait(lock);
+				}
+			}
+
+			--this->waiting[index];
+			this->busy = true;
+		}
+
+		/*!
+			@brief	takes over the bandwidth budget of src, no command may be scheduled on either side
+		*/
+		command_scheduler::command_scheduler(command_scheduler&& src) noexcept {
+			const std::lock_guard<std::mutex> lock(src.mtx);
+
+			this->rate = src.rate;
+			this->burst = src.burst;
+			this->tokens = src.tokens;
+			this->last_refill = src.last_refill;
+		}
+
+		auto command_scheduler::operator=(command_scheduler&& src) noexcept -> command_scheduler& {
+			if (this != &src) {
+				const std::scoped_lock lock(this->mtx, src.mtx);
+
+				this->rate = src.rate;
+				this->burst = src.burst;
+				this->tokens = src.tokens;
+				this->last_refill = src.last_refill;
+			}
+
+			return *this;
+		}
+
+		/*!
+			@return	Returns the number of commands waiting for the connection.
+		*/
+		auto command_scheduler::queued() const -> size_t {
+			const std::lock_guard<std::mutex> lock(this->mtx);
+			return std::accumulate(this->waiting.begin(), this->waiting.end(), size_t{0});
+		}
+
+		auto command_scheduler::release() -> void {
+			{
+				const std::lock_guard<std::mutex> lock(this->mtx);
+				this->busy = false;
+			}
+
+			this->cv.notify_all();
+		}
+
+		auto command_scheduler::set_bandwidth_limit(size_t bytes_per_second, size_t burst) -> void {
+			{
+				const std::lock_guard<std::mutex> lock(this->mtx);
+
+				this->rate = bytes_per_second;
+				this->burst = burst > 0 ? burst : bytes_per_second;
+				this->tokens = static_cast<double>(this->burst);
+				this->last_refill = std::chrono::steady_clock::now();
+			}
+
+			this->cv.notify_all();
+		}
+
+		/*!
+			@brief	takes transferred bytes from the bucket, it may go into debt which is paid off
+					before the next throttled command starts
+		*/
+		auto command_scheduler::account(size_t bytes) -> void {
+			const std::lock_guard<std::mutex> lock(this->mtx);
+
+			if (this->rate == 0) {
+				return;
+			}
+
+			this->refill();
+			this->tokens -= static_cast<double>(bytes);
+		}
+
+		auto command_scheduler::refill() -> void {
+			const auto now = std::chrono::steady_clock::now();
+
+			if (this->rate > 0) {
+				const auto elapsed = std::chrono::duration<double>(now - this->last_refill).count();
+				this->tokens = std::min(static_cast<double>(this->burst),
+										this->tokens + elapsed * static_cast<double>(this->rate));
+			}
+
+			this->last_refill = now;
+		}
 
-		// 	std::swap(this->sockfd, src.sockfd);
-		// 	std::swap(this->connected, src.connected);
-		// 	std::swap(this->timeout, src.timeout);
-		// 	std::swap(this->remote, src.remote);
-		// 	std::swap(this->res, src.res);
-		// 	std::swap(this->user_name, src.user_name);
-		// 	std::swap(this->conn_target, src.conn_target);
-		// 	std::swap(this->conn_port, src.conn_port);
-		// 	std::swap(this->user_level, src.user_level);
-		// 	std::swap(this->use_msgpack, src.use_msgpack);
-		// 	std::swap(this->silent, src.silent);
+		scheduled_lock::scheduled_lock(command_scheduler& scheduler, std::mutex& mtx) : scheduler(scheduler) {
+			this->scheduler.acquire(command_priority_scope::current());
+			this->lock = std::unique_lock<std::mutex>(mtx);
+		}
 
-		// 	std::swap(this->s, src.s);
-		// 	std::swap(this->io_context, src.io_context);
-		// }
+		scheduled_lock::~scheduled_lock() {
+			this->lock.unlock();
+			this->scheduler.release();
+		}
 
 		auto netHelper_base::get_mutex() -> std::mutex& {
 			return this->sock_mtx;
@@ -92,22 +340,59 @@ namespace bestsens {
 		}
 
 		auto netHelper_base::sha512(const std::string& input) -> std::string {
-			std::array<unsigned char, SHA512_DIGEST_LENGTH> hash{};
+			static constexpr std::array<char, 16> hex_digits{'0', '1', '2', '3', '4', '5', '6', '7',
+															 '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
 
-			std::vector<char> hash_hex{};
-			hash_hex.reserve(static_cast<long>(SHA512_DIGEST_LENGTH) * 2);
+			std::array<unsigned char, SHA512_DIGEST_LENGTH> hash{};
 
 			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
 			SHA512(reinterpret_cast<const unsigned char*>(input.c_str()), input.length(), hash.data());
 
-			for (const auto& e : hash) {
-				fmt::format_to(std::back_inserter(hash_hex), "{:02x}", e);
+			std::string hash_hex(hash.size() * 2, '\0');
+
+			for (size_t i = 0; i < hash.size(); ++i) {
+				hash_hex[2 * i] = hex_digits[hash[i] >> 4u];
+				hash_hex[2 * i + 1] = hex_digits[hash[i] & 0x0fu];
 			}
 
-			return {hash_hex.begin(), hash_hex.end()};
+			return hash_hex;
 		}
 
+		/*!
+			@brief	authenticates the connection
+			@param	use_hash: `password` is already the sha512 hash of the password
+
+			Is the connection already logged in with the same credentials, no request is sent.
+			After a reconnect a session token received on the previous login is tried first (one
+			round trip), the regular request_token/auth sequence is only used as fallback.
+			@return	Returns the user level, 0 if the login failed.
+		*/
 		auto netHelper_base::login(const std::string& user_name, const std::string& password, bool use_hash) -> int {
+			const auto hashed_password = use_hash ? password : this->sha512(password);
+			const auto same_credentials = user_name == this->user_name && hashed_password == this->password_hash;
+
+			if (same_credentials && this->user_level > 0) {
+				return this->user_level;
+			}
+
+			/*
+			* resume session
+			*/
+			if (same_credentials && !this->session_token.empty()) {
+				json session_response;
+
+				this->send_command("auth", session_response, {{"session_token", this->session_token}, {"username", user_name}});
+
+				const auto level = value_ig_type(session_response.value("payload", json::object()), "user_level", 0);
+
+				if (level > 0) {
+					this->user_level = level;
+					return this->user_level;
+				}
+
+				this->session_token.clear();
+			}
+
 			/*
 			* request token
 			*/
@@ -121,12 +406,6 @@ namespace bestsens {
 			}
 
 			const auto token = token_response.at("payload").at("token").get<std::string>();
-			const auto hashed_password = [&]() -> std::string {
-				if (use_hash)
-					return password;
-
-				return this->sha512(password);
-			}();
 
 			/*
 			* sign token
@@ -156,9 +435,27 @@ namespace bestsens {
 
 			this->user_level = login_response.at("payload").at("user_level").get<int>();
 
+			if (this->user_level > 0) {
+				this->user_name = user_name;
+				this->password_hash = hashed_password;
+				this->session_token = value_ig_type(login_response.at("payload"), "session_token", std::string{});
+			}
+
 			return this->user_level;
 		}
 
+		/*!
+			@brief	repeats the last login, e.g. after a reconnect
+			@return	Returns the user level, 0 if there was no previous login or it failed.
+		*/
+		auto netHelper_base::relogin() -> int {
+			if (this->password_hash.empty()) {
+				return 0;
+			}
+
+			return this->login(this->user_name, this->password_hash, true);
+		}
+
 		auto netHelper_base::is_logged_in() const -> int {
 			return this->user_level;
 		}
@@ -172,7 +469,29 @@ namespace bestsens {
 			this->timeout = timeout_ms;
 		}
 
-		auto netHelper_base::send_command(const std::string& command, json& response, const json& payload, int api_version) -> int {
+		/*!
+			@brief	limits all following I/O to end before `deadline` in addition to the timeout of
+					each operation, e.g. to bound connect, login and a command together;
+					time_point::max() removes the limit
+		*/
+		auto netHelper_base::set_deadline(std::chrono::steady_clock::time_point deadline) -> void {
+			this->deadline = deadline;
+		}
+
+		auto netHelper_base::deadline_after(unsigned int timeout_ms) const -> std::chrono::steady_clock::time_point {
+			const auto now = std::chrono::steady_clock::now();
+
+			if (this->deadline <= now) {
+				return now;
+			}
+
+			// compared as duration, now + timeout could overflow for the default deadline
+			return now + std::min<std::chrono::steady_clock::duration>(std::chrono::milliseconds(timeout_ms),
+																	   this->deadline - now);
+		}
+
+		auto netHelper_base::send_request(const std::string& command, const json& payload, int api_version,
+										  bool binary_attachments) -> void {
 			json temp = {{"command", command}};
 
 			if (payload.is_object()) {
@@ -183,24 +502,118 @@ namespace bestsens {
 				temp["api"] = api_version;
 			}
 
-			const std::lock_guard<std::mutex> lock(this->sock_mtx);
+			if (binary_attachments) {
+				temp["binary_attachments"] = true;
+			}
 
 			/*
 			* send data to server
 			*/
+			std::string data;
+
 			if (!this->use_msgpack) {
-				this->send(fmt::format("{}\r\n", temp.dump()));
+				data = temp.dump();
 			} else {
-				std::vector<uint8_t> v_msgpack = json::to_msgpack(temp);
-				v_msgpack.push_back('\r');
-				v_msgpack.push_back('\n');
+				json::to_msgpack(temp, data);
+			}
 
-				this->send(v_msgpack);
+			data.append(request_delimiter);
+
+			this->send_encoded(data);
+		}
+
+		/*!
+			@brief	sends a complete request including the trailing delimiter, compressed if negotiated
+		*/
+		auto netHelper_base::send_encoded(const std::string& request) -> void {
+			if (!this->send_compressed(request.data(), request.size() - request_delimiter.size())) {
+				this->send(request);
 			}
+		}
 
-			/*
-			* receive data length
-			*/
+		/*!
+			@brief	sends a request as length-prefixed zstd frame if compression was negotiated and the
+					request exceeds the threshold
+			@return	Returns true if the request was sent.
+		*/
+		auto netHelper_base::send_compressed([[maybe_unused]] const void* data, [[maybe_unused]] size_t size) -> bool {
+#ifdef ENABLE_ZSTD_COMPRESSION
+			if (!this->compression_active || size < this->compression_threshold) {
+				return false;
+			}
+
+			const auto compressed = compress_zstd(data, size);
+			this->send(fmt::format("{:08x}{}", compressed.size(), compressed));
+
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		/*!
+			@brief	decompresses a received frame in place if it is zstd compressed
+		*/
+		auto netHelper_base::decode_frame(std::vector<uint8_t>& data) const -> void {
+			if (!is_zstd_frame(data.data(), data.size())) {
+				return;
+			}
+
+#ifdef ENABLE_ZSTD_COMPRESSION
+			data = decompress_zstd(data);
+#else
+			throw std::runtime_error("received compressed frame but compression support is disabled");
+#endif
+		}
+
+		/*!
+			@brief	negotiates zstd compression for requests and responses larger than threshold bytes
+			@return	Returns true if the server accepted compression.
+		*/
+		auto netHelper_base::enable_compression([[maybe_unused]] size_t threshold) -> bool {
+#ifdef ENABLE_ZSTD_COMPRESSION
+			this->compression_active = false;
+
+			json response;
+			this->send_command("set_compression", response, {{"type", "zstd"}, {"threshold", threshold}});
+
+			if (!is_json_object(response, "payload") ||
+				value_ig_type(response.at("payload"), "compression", std::string{}) != "zstd") {
+				return false;
+			}
+
+			this->compression_threshold = threshold;
+			this->compression_active = true;
+
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		auto netHelper_base::is_compression_enabled() const -> bool {
+			return this->compression_active;
+		}
+
+		auto netHelper_base::metrics() const -> metrics_snapshot {
+			return this->stats.snapshot();
+		}
+
+		/*!
+			@brief	limits the bandwidth used by normal and bulk priority commands
+			@param	bytes_per_second: sustained rate, 0 disables the limit
+			@param	burst: bytes that may be transferred at once, defaults to one second worth
+		*/
+		auto netHelper_base::set_bandwidth_limit(size_t bytes_per_second, size_t burst) -> void {
+			this->scheduler.set_bandwidth_limit(bytes_per_second, burst);
+		}
+
+		auto netHelper_base::record_transfer(uint64_t metrics_snapshot::*counter, size_t bytes) -> void {
+			this->stats.add(counter, bytes);
+			this->scheduler.account(bytes);
+		}
+
+		auto netHelper_base::recv_data_length() -> unsigned long {
 			unsigned long data_len = 0;
 			std::array<char, 9> len_buffer{};
 
@@ -209,6 +622,79 @@ namespace bestsens {
 				data_len = strtoul(static_cast<char*>(len_buffer.data()), nullptr, 16);
 			}
 
+			return data_len;
+		}
+
+		/*!
+			@brief	receives a complete, decompressed response frame
+		*/
+		auto netHelper_base::recv_frame() -> std::vector<uint8_t> {
+			const auto data_len = this->recv_data_length();
+			std::vector<uint8_t> str(data_len);
+
+			const auto t = this->recv(str.data(), data_len);
+
+			if (t <= 0 || static_cast<unsigned long>(t) != data_len) {
+				if (!this->silent) spdlog::critical("could not receive all data");
+				throw std::runtime_error("could not receive all data");
+			}
+
+			this->decode_frame(str);
+
+			return str;
+		}
+
+		auto netHelper_base::parse_frame(const std::vector<uint8_t>& data) -> json {
+			const auto start = metrics_recorder::start();
+
+			auto j = this->use_msgpack ? json::from_msgpack(data) : json::parse(data);
+
+			this->stats.record(this->use_msgpack ? &metrics_snapshot::parse_msgpack : &metrics_snapshot::parse_json, start);
+
+			return j;
+		}
+
+		auto netHelper_base::send_command(const std::string& command, json& response, const json& payload, int api_version) -> int {
+			this->check_subscription();
+
+			const scheduled_lock lock(this->scheduler, this->sock_mtx);
+			const auto start = metrics_recorder::start();
+
+			this->send_request(command, payload, api_version);
+
+			return this->recv_response(response, start);
+		}
+
+		/*!
+			@brief	sends a prepared command, only the already encoded request is written to the socket
+			@return	Returns 1 on success, 0 if the response could not be parsed.
+		*/
+		auto netHelper_base::send_command(const prepared_command& command, json& response) -> int {
+			if (command.is_msgpack() != this->use_msgpack) {
+				throw std::invalid_argument("prepared command uses a different encoding than the connection");
+			}
+
+			this->check_subscription();
+
+			const scheduled_lock lock(this->scheduler, this->sock_mtx);
+			const auto start = metrics_recorder::start();
+
+			this->send_encoded(command.encoded());
+
+			return this->recv_response(response, start);
+		}
+
+		auto netHelper_base::prepare(const std::string& command, const json& payload, int api_version) const
+			-> prepared_command {
+			return {command, payload, api_version, this->use_msgpack};
+		}
+
+		auto netHelper_base::recv_response(json& response, metrics_recorder::clock::time_point start) -> int {
+			/*
+			* receive data length
+			*/
+			const auto data_len = this->recv_data_length();
+
 			/*
 			* receive actual data and parse
 			*/
@@ -216,16 +702,15 @@ namespace bestsens {
 
 			const auto t = this->recv(str.data(), data_len);
 
+			this->stats.record(&metrics_snapshot::command, start);
+
 			if (t > 0 && static_cast<unsigned long>(t) == data_len) {
-				str[t] = '\0';
+				str.resize(data_len);
 
 				try {
-					if (!this->use_msgpack)
-						response = json::parse(str);
-					else {
-						str.erase(str.begin() + t);
-						response = json::from_msgpack(str);
-					}
+					this->decode_frame(str);
+
+					response = this->parse_frame(str);
 
 					if (response.empty()) {
 						if (!this->silent) spdlog::error("Error");
@@ -244,132 +729,1136 @@ namespace bestsens {
 					spdlog::critical("input string: \"{:c}\"", fmt::join(str, ""));
 				}
 
-				throw std::runtime_error("could not receive all data");
+				throw std::runtime_error("could not receive all data");
+			}
+
+			return 0;
+		}
+
+		/*!
+			@brief	sends a command offering binary attachments and receives the envelope and all attachments
+			@return	Returns 1 on success, 0 if the envelope could not be parsed.
+
+			If the response can not be received completely the connection is closed, the remaining
+			attachments would otherwise be read as response of the next command.
+		*/
+		auto netHelper_base::send_command(const std::string& command, binary_response& response, const json& payload,
+										  int api_version) -> int {
+			this->check_subscription();
+
+			const scheduled_lock lock(this->scheduler, this->sock_mtx);
+			const auto start = metrics_recorder::start();
+
+			this->send_request(command, payload, api_version, true);
+
+			try {
+				return this->recv_binary_response(response, start);
+			} catch (...) {
+				this->drop_connection();
+				throw;
+			}
+		}
+
+		auto netHelper_base::recv_binary_response(binary_response& response, metrics_recorder::clock::time_point start)
+			-> int {
+			const auto str = this->recv_frame();
+
+			this->stats.record(&metrics_snapshot::command, start);
+
+			response.attachments.clear();
+
+			try {
+				response.envelope = this->parse_frame(str);
+			} catch (const json::exception& ia) {
+				if (!this->silent) spdlog::error("{}", ia.what());
+
+				// the number of attachments following is unknown
+				this->drop_connection();
+				return 0;
+			}
+
+			if (!is_json_array(response.envelope, "attachments")) {
+				return 1;
+			}
+
+			for (const auto& e : response.envelope.at("attachments")) {
+				const size_t blob_len = this->recv_data_length();
+
+				// recv() reports the received size as int
+				if (blob_len > static_cast<size_t>(std::numeric_limits<int>::max())) {
+					throw std::runtime_error("attachment too large");
+				}
+
+				auto& blob = response.attachments.emplace_back(blob_len);
+
+				if (blob_len > 0 && this->recv(blob.data(), blob_len) != static_cast<int>(blob_len)) {
+					throw std::runtime_error("could not receive all data");
+				}
+
+				if (value_ig_type(e, "size", blob_len) != blob_len) {
+					throw std::runtime_error("attachment size mismatch");
+				}
+			}
+
+			return 1;
+		}
+
+		namespace {
+			/*
+			 * Exposes a single response frame as an input range that is received from the socket
+			 * in chunks while the parser consumes it.
+			 */
+			class chunked_frame_reader {
+			public:
+				class iterator {
+				public:
+					using iterator_category = std::input_iterator_tag;
+					using value_type = char;
+					using difference_type = std::ptrdiff_t;
+					using pointer = const char*;
+					using reference = const char&;
+
+					iterator() = default;
+					explicit iterator(chunked_frame_reader* reader) : reader(reader) {}
+
+					auto operator*() const -> reference {
+						return this->reader->current();
+					}
+
+					auto operator++() -> iterator& {
+						this->reader->advance();
+						return *this;
+					}
+
+					auto operator++(int) -> iterator {
+						auto tmp = *this;
+						++(*this);
+						return tmp;
+					}
+
+					friend auto operator==(const iterator& lhs, const iterator& rhs) -> bool {
+						return lhs.at_end() == rhs.at_end();
+					}
+
+				private:
+					chunked_frame_reader* reader{nullptr};
+
+					auto at_end() const -> bool {
+						return this->reader == nullptr || this->reader->done();
+					}
+				};
+
+				static constexpr size_t chunk_size = 64 * 1024;
+
+				chunked_frame_reader(netHelper_base& conn, size_t frame_size)
+					: conn(conn), remaining(frame_size), buffer(std::min(frame_size, chunk_size)) {
+					this->filled = this->read_raw(this->buffer);
+
+					if (is_zstd_frame(this->buffer.data(), this->filled)) {
+#ifdef ENABLE_ZSTD_COMPRESSION
+						this->dctx.reset(ZSTD_createDCtx());
+						this->input = std::exchange(this->buffer, std::vector<char>(ZSTD_DStreamOutSize()));
+						this->input_filled = std::exchange(this->filled, 0);
+						this->fill();
+#else
+						throw std::runtime_error("received compressed frame but compression support is disabled");
+#endif
+					}
+				}
+
+				auto begin() -> iterator {
+					return iterator(this);
+				}
+
+				static auto end() -> iterator {
+					return {};
+				}
+
+				auto done() const -> bool {
+					return this->position == this->filled && this->exhausted;
+				}
+
+				/*
+				 * consume whatever the parser left over so the next frame starts in sync
+				 */
+				auto drain() -> void {
+					while (this->remaining > 0) {
+						this->read_raw(this->buffer);
+					}
+
+					this->position = this->filled;
+					this->exhausted = true;
+				}
+
+			private:
+				netHelper_base& conn;
+				size_t remaining;
+				std::vector<char> buffer;
+				size_t position{0};
+				size_t filled{0};
+				bool exhausted{false};
+
+#ifdef ENABLE_ZSTD_COMPRESSION
+				zstd_dctx_ptr dctx{};
+				std::vector<char> input{};
+				size_t input_position{0};
+				size_t input_filled{0};
+#endif
+
+				auto current() const -> const char& {
+					return this->buffer[this->position];
+				}
+
+				auto advance() -> void {
+					if (++this->position == this->filled) {
+						this->fill();
+					}
+				}
+
+				auto read_raw(std::vector<char>& target) -> size_t {
+					const auto read_size = std::min(this->remaining, target.size());
+					const auto t = this->conn.recv(target.data(), read_size);
+
+					if (t <= 0 || static_cast<size_t>(t) != read_size) {
+						throw std::runtime_error("could not receive all data");
+					}
+
+					this->remaining -= read_size;
+					return read_size;
+				}
+
+				auto fill() -> void {
+					this->position = 0;
+					this->filled = 0;
+
+#ifdef ENABLE_ZSTD_COMPRESSION
+					if (this->dctx) {
+						while (this->filled == 0) {
+							if (this->input_position == this->input_filled && this->remaining > 0) {
+								this->input_filled = this->read_raw(this->input);
+								this->input_position = 0;
+							}
+
+							ZSTD_outBuffer out{this->buffer.data(), this->buffer.size(), 0};
+							ZSTD_inBuffer in{this->input.data(), this->input_filled, this->input_position};
+
+							const auto t = ZSTD_decompressStream(this->dctx.get(), &out, &in);
+
+							if (ZSTD_isError(t) != 0u) {
+								throw std::runtime_error(fmt::format("decompression failed: {}", ZSTD_getErrorName(t)));
+							}
+
+							this->input_position = in.pos;
+							this->filled = out.pos;
+
+							if (out.pos == 0 && in.pos == in.size && this->remaining == 0) {
+								this->exhausted = true;
+								return;
+							}
+						}
+
+						return;
+					}
+#endif
+
+					if (this->remaining == 0) {
+						this->exhausted = true;
+						return;
+					}
+
+					this->filled = this->read_raw(this->buffer);
+				}
+			};
+		}  // namespace
+
+		/*!
+			@brief	sends a command and feeds the response into a SAX parser while it is being received
+			@return	Returns 1 on success, 0 if the response could not be parsed.
+		*/
+		auto netHelper_base::send_command(const std::string& command, json::json_sax_t& sax, const json& payload,
+										  int api_version) -> int {
+			this->check_subscription();
+
+			const scheduled_lock lock(this->scheduler, this->sock_mtx);
+			const auto start = metrics_recorder::start();
+
+			this->send_request(command, payload, api_version);
+
+			const auto data_len = this->recv_data_length();
+
+			if (data_len == 0) {
+				if (!this->silent) spdlog::critical("could not receive all data");
+				throw std::runtime_error("could not receive all data");
+			}
+
+			const auto format = this->use_msgpack ? json::input_format_t::msgpack : json::input_format_t::json;
+			bool success = false;
+
+			// the rest of the frame is unknown if the handler or a receive throws part way
+			try {
+				chunked_frame_reader reader(*this, data_len);
+
+				success = json::sax_parse(reader.begin(), chunked_frame_reader::end(), &sax, format, false);
+
+				reader.drain();
+			} catch (...) {
+				this->drop_connection();
+				throw;
+			}
+
+			this->stats.record(&metrics_snapshot::command, start);
+
+			if (!success) {
+				if (!this->silent) spdlog::error("error parsing response to \"{}\"", command);
+				return 0;
+			}
+
+			return 1;
+		}
+
+		/*!
+			@brief	like the streaming SAX send_command(), but parses the complete frame once received
+
+			The contiguous buffer parses considerably faster than the chunked reader, use it
+			when the response size is not a concern.
+		*/
+		auto netHelper_base::send_command_buffered(const std::string& command, json::json_sax_t& sax,
+												   const json& payload, int api_version) -> int {
+			this->check_subscription();
+
+			const scheduled_lock lock(this->scheduler, this->sock_mtx);
+			const auto start = metrics_recorder::start();
+
+			this->send_request(command, payload, api_version);
+
+			const auto frame = this->recv_frame();
+
+			this->stats.record(&metrics_snapshot::command, start);
+
+			const auto format = this->use_msgpack ? json::input_format_t::msgpack : json::input_format_t::json;
+
+			if (!json::sax_parse(frame.begin(), frame.end(), &sax, format, false)) {
+				if (!this->silent) spdlog::error("error parsing response to \"{}\"", command);
+				return 0;
+			}
+
+			return 1;
+		}
+
+		auto netHelper_base::getCommandReturnPayload(const std::string& command, const json& payload, int api_version) -> json {
+			json j;
+			const auto retval = this->send_command(command, j, payload, api_version);
+
+			return return_payload_of(retval, j);
+		}
+
+		auto netHelper_base::getCommandReturnPayload(const prepared_command& command) -> json {
+			json j;
+			const auto retval = this->send_command(command, j);
+
+			return return_payload_of(retval, j);
+		}
+
+		auto netHelper_base::return_payload_of(int retval, json& j) -> json {
+			if (retval == 0) {
+				throw std::runtime_error("unknown error");
+			}
+
+			if (!is_json_object(j, "payload")) {
+				return {};
+			}
+
+			auto &return_payload = j.at("payload");
+
+			if (is_json_string(return_payload, "error")) {
+				throw std::runtime_error(return_payload.at("error").get<std::string>());
+			}
+
+			return std::move(return_payload);
+		}
+
+		namespace {
+			// connection whose subscription callback runs on the current thread
+			thread_local const netHelper_base* dispatching_for = nullptr;
+		}  // namespace
+
+		struct netHelper_base::subscription {
+			subscription_callback callback;
+			size_t queue_size;
+			bool drop_oldest;
+
+			// "command" values of the pushed frames, to tell them apart from the unsubscribe response
+			std::set<std::string> pushed_commands{};
+
+			std::atomic<bool> running{true};
+			std::atomic<bool> failed{false};
+
+			std::mutex mtx{};
+			std::condition_variable cv{};
+			std::deque<json> queue{};
+
+			std::thread reader{};
+			std::thread dispatcher{};
+		};
+
+		/*!
+			@brief	sends a subscribe command and dispatches all frames pushed by the server afterwards to
+					callback on a separate thread
+			@param	queue_size: maximum number of frames waiting for the callback; when full the reader
+					stops receiving (backpressure) or, with drop_oldest, discards the oldest frame
+			@return	Returns the payload of the subscribe response.
+
+			No other commands can be sent on the connection until unsubscribe() is called. The
+			callback must not call unsubscribe() itself; exceptions thrown by it are logged and
+			dropped. If receiving fails (connection lost, invalid frame) the subscription ends on its
+			own, is_subscribed() returns false and the next command clears it.
+		*/
+		auto netHelper_base::subscribe(const std::string& command, subscription_callback callback, const json& payload,
+									   size_t queue_size, bool drop_oldest) -> json {
+			auto response = this->getCommandReturnPayload(command, payload);
+
+			this->active_subscription = std::make_unique<subscription>(std::move(callback), std::max<size_t>(queue_size, 1),
+																	   drop_oldest);
+			auto& sub = *this->active_subscription;
+			sub.pushed_commands.insert(command);
+
+			sub.reader = std::thread([this, &sub]() {
+				constexpr unsigned int poll_interval_ms = 100;
+
+				while (sub.running) {
+					try {
+						if (!this->wait_readable(poll_interval_ms)) {
+							continue;
+						}
+
+						const auto frame = [&]() {
+							const scheduled_lock lock(this->scheduler, this->sock_mtx);
+							return this->recv_frame();
+						}();
+
+						auto j = this->parse_frame(frame);
+
+						std::unique_lock<std::mutex> lock(sub.mtx);
+
+						if (auto name = value_ig_type(j, "command", std::string{}); !name.empty()) {
+							sub.pushed_commands.insert(std::move(name));
+						}
+
+						if (sub.drop_oldest) {
+							if (sub.queue.size() >= sub.queue_size) {
+								sub.queue.pop_front();
+							}
+						} else {
+							sub.cv.wait(lock, [&sub]() { return sub.queue.size() < sub.queue_size || !sub.running; });
+						}
+
+						sub.queue.push_back(std::move(j));
+						lock.unlock();
+						sub.cv.notify_all();
+					} catch (const std::exception& e) {
+						if (!this->silent) spdlog::error("subscription failed: {}", e.what());
+
+						sub.failed = true;
+						break;
+					}
+				}
+
+				{
+					const std::lock_guard<std::mutex> lock(sub.mtx);
+					sub.running = false;
+				}
+
+				sub.cv.notify_all();
+			});
+
+			sub.dispatcher = std::thread([this, &sub]() {
+				dispatching_for = this;
+
+				while (true) {
+					std::unique_lock<std::mutex> lock(sub.mtx);
+					sub.cv.wait(lock, [&sub]() { return !sub.queue.empty() || !sub.running; });
+
+					if (sub.queue.empty()) {
+						break;
+					}
+
+					const auto frame = std::move(sub.queue.front());
+					sub.queue.pop_front();
+					lock.unlock();
+					sub.cv.notify_all();
+
+					// a failing callback only loses its frame, the following ones are still dispatched
+					try {
+						sub.callback(frame);
+					} catch (const std::exception& e) {
+						if (!this->silent) spdlog::error("subscription callback failed: {}", e.what());
+					} catch (...) {
+						if (!this->silent) spdlog::error("subscription callback failed");
+					}
+				}
+			});
+
+			return response;
+		}
+
+		/*!
+			@brief	commands can not be sent while subscribed, except after the subscription ended on an error
+
+			Called before the connection is locked: tearing down a failed subscription waits for
+			the callback, which may be waiting for the connection itself.
+		*/
+		auto netHelper_base::check_subscription() -> void {
+			// the callback would wait for its own thread to end
+			if (dispatching_for == this) {
+				throw std::logic_error("connection is in subscription mode");
+			}
+
+			const std::lock_guard<std::mutex> lock(this->subscription_mtx);
+
+			if (!this->active_subscription) {
+				return;
+			}
+
+			if (!this->active_subscription->failed) {
+				throw std::logic_error("connection is in subscription mode");
+			}
+
+			// the reader has exited already, only the remaining frames are dispatched
+			this->stop_subscription();
+		}
+
+		/*!
+			@return	Returns the ended subscription, nullptr if there was none.
+		*/
+		auto netHelper_base::stop_subscription() -> std::unique_ptr<subscription> {
+			if (!this->active_subscription) {
+				return nullptr;
+			}
+
+			auto& sub = *this->active_subscription;
+
+			{
+				const std::lock_guard<std::mutex> lock(sub.mtx);
+				sub.running = false;
+			}
+
+			sub.cv.notify_all();
+
+			sub.reader.join();
+			sub.dispatcher.join();
+
+			return std::move(this->active_subscription);
+		}
+
+		/*!
+			@brief	stops dispatching and sends the unsubscribe command; frames still in flight are discarded
+		*/
+		auto netHelper_base::unsubscribe(const std::string& command) -> void {
+			const auto ended = [this]() {
+				const std::lock_guard<std::mutex> lock(this->subscription_mtx);
+				return this->stop_subscription();
+			}();
+
+			if (!ended || ended->failed || !this->connected) {
+				return;
+			}
+
+			const scheduled_lock lock(this->scheduler, this->sock_mtx);
+
+			this->send_request(command, {}, 0);
+
+			// frames pushed before the server handled the request are skipped, the response does
+			// not have to name the command
+			while (true) {
+				const auto frame = this->recv_frame();
+				const auto j = this->parse_frame(frame);
+
+				if (!ended->pushed_commands.contains(value_ig_type(j, "command", std::string{}))) {
+					break;
+				}
+			}
+		}
+
+		auto netHelper_base::is_subscribed() const -> bool {
+			return this->active_subscription && this->active_subscription->running;
+		}
+
+		auto netHelper_base::is_connected() const -> bool {
+			return this->connected;
+		}
+
+		/*!
+			@brief	connects socket
+			@return	Returns 0 on success, != 0 for errors.
+		*/
+		auto netHelper_base::connect() -> int {
+			return 0;
+		}
+
+		void netHelper_base::disconnect() {}
+
+		auto netHelper_base::send(const char * data) -> int {
+			return this->send(std::string(data));
+		}
+
+		auto netHelper_base::send(const std::vector<uint8_t>& data) -> int {
+			const std::string s(data.begin(), data.end());
+			return this->send(s);
+		}
+
+		auto netHelper_base::send(const std::string&  /*data*/) -> int {
+			return 0;
+		}
+
+		auto netHelper_base::recv(void *  /*buffer*/, size_t  /*read_size*/) -> int {
+			return 0;
+		}
+
+		auto netHelper_base::wait_readable(unsigned int /*timeout_ms*/) -> bool {
+			return false;
+		}
+
+		auto netHelper_base::cancel_io() -> void {}
+
+		auto netHelper_base::shutdown_socket() -> void {}
+
+		/*!
+			@brief	closes the connection, sock_mtx has to be held; used when the position in the
+					response stream is unknown and the next command would read a stale frame
+		*/
+		auto netHelper_base::drop_connection() -> void {
+			this->shutdown_socket();
+
+			this->connected = false;
+			this->compression_active = false;
+			this->user_level = 0;
+		}
+
+		/*!
+			@brief	runs the io_context until the pending operation completed or the timeout passed
+
+			The deadline is enforced by run_one_until() instead of arming a deadline_timer for
+			every operation, so a send or recv costs no timer (de)registration on the reactor.
+			On timeout the operation is cancelled and its handler is run before returning; unless
+			`is_poll` is set, the timeout is counted in the metrics.
+			@return	Returns the result of the operation, operation_aborted on timeout.
+		*/
+		auto netHelper_base::run_io(const boost::optional<boost::system::error_code>& result, unsigned int timeout_ms,
+									bool is_poll) -> boost::system::error_code {
+			if (this->io_context->stopped()) {
+				this->io_context->restart();
+			}
+
+			const auto deadline = this->deadline_after(timeout_ms);
+
+			while (!result && this->io_context->run_one_until(deadline) != 0u) {}
+
+			if (!result) {
+				if (!is_poll) {
+					this->stats.add(&metrics_snapshot::timeouts);
+				}
+
+				this->cancel_io();
+
+				if (this->io_context->stopped()) {
+					this->io_context->restart();
+				}
+
+				while (!result && this->io_context->run_one() != 0u) {}
+			}
+
+			return result.value_or(boost::asio::error::operation_aborted);
+		}
+
+		namespace {
+			/*
+			 * Process wide cache of resolved endpoints, getaddrinfo does not report the record TTL
+			 * so entries expire after a fixed time.
+			 */
+			struct dns_cache_entry {
+				std::vector<tcp::endpoint> endpoints;
+				std::chrono::steady_clock::time_point expires;
+			};
+
+			std::mutex dns_cache_mtx;
+			std::map<std::string, dns_cache_entry> dns_cache;
+			std::chrono::seconds dns_cache_ttl{60};
+
+			// delay before racing the next address, see RFC 8305 section 5
+			constexpr auto connection_attempt_delay = std::chrono::milliseconds(250);
+
+			/*
+			 * reorders the endpoints so address families alternate, starting with the preferred one
+			 */
+			auto interleave_families(const tcp::resolver::results_type& results) -> std::vector<tcp::endpoint> {
+				std::vector<tcp::endpoint> first;
+				std::vector<tcp::endpoint> second;
+
+				for (const auto& e : results) {
+					if (first.empty() || e.endpoint().protocol() == first.front().protocol()) {
+						first.push_back(e.endpoint());
+					} else {
+						second.push_back(e.endpoint());
+					}
+				}
+
+				std::vector<tcp::endpoint> endpoints;
+				endpoints.reserve(first.size() + second.size());
+
+				for (size_t i = 0; i < std::max(first.size(), second.size()); ++i) {
+					if (i < first.size()) {
+						endpoints.push_back(first[i]);
+					}
+
+					if (i < second.size()) {
+						endpoints.push_back(second[i]);
+					}
+				}
+
+				return endpoints;
+			}
+		}  // namespace
+
+		/*!
+			@brief	sets how long resolved addresses are reused, 0 disables the cache
+		*/
+		auto netHelper_base::set_dns_cache_ttl(std::chrono::seconds ttl) -> void {
+			const std::lock_guard<std::mutex> lock(dns_cache_mtx);
+			dns_cache_ttl = ttl;
+			dns_cache.clear();
+		}
+
+		auto netHelper_base::get_dns_cache_ttl() -> std::chrono::seconds {
+			const std::lock_guard<std::mutex> lock(dns_cache_mtx);
+			return dns_cache_ttl;
+		}
+
+		auto netHelper_base::clear_dns_cache() -> void {
+			const std::lock_guard<std::mutex> lock(dns_cache_mtx);
+			dns_cache.clear();
+		}
+
+		/*!
+			@brief	resolves the target asynchronously, giving up at the deadline
+		*/
+		auto netHelper_base::resolve(std::chrono::steady_clock::time_point deadline) -> std::vector<tcp::endpoint> {
+			const auto key = fmt::format("{}:{}", this->conn_target, this->conn_port);
+
+			{
+				const std::lock_guard<std::mutex> lock(dns_cache_mtx);
+				const auto it = dns_cache.find(key);
+
+				if (it != dns_cache.end() && it->second.expires > std::chrono::steady_clock::now()) {
+					return it->second.endpoints;
+				}
+			}
+
+			/*
+			 * getaddrinfo can not be interrupted, so a timed out lookup is abandoned instead of
+			 * waited for: the handler only touches state it shares ownership of.
+			 */
+			struct resolve_state {
+				boost::optional<boost::system::error_code> result;
+				tcp::resolver::results_type results;
+			};
+
+			const auto state = std::make_shared<resolve_state>();
+
+			tcp::resolver resolver(*this->io_context);
+			resolver.async_resolve(this->conn_target, this->conn_port,
+								   [state](const boost::system::error_code& error, tcp::resolver::results_type results) {
+									   state->result = error;
+									   state->results = std::move(results);
+								   });
+
+			if (this->io_context->stopped()) {
+				this->io_context->restart();
+			}
+
+			while (!state->result && this->io_context->run_one_until(deadline) != 0u) {}
+
+			if (!state->result) {
+				this->stats.add(&metrics_snapshot::timeouts);
+				resolver.cancel();
+				throw boost::system::system_error(boost::asio::error::timed_out, "resolve");
+			}
+
+			if (*state->result) {
+				throw boost::system::system_error(*state->result, "resolve");
+			}
+
+			auto endpoints = interleave_families(state->results);
+
+			const std::lock_guard<std::mutex> lock(dns_cache_mtx);
+
+			if (dns_cache_ttl.count() > 0) {
+				dns_cache[key] = {endpoints, std::chrono::steady_clock::now() + dns_cache_ttl};
+			}
+
+			return endpoints;
+		}
+
+		/*!
+			@brief	connects `socket` to the target within the timeout
+
+			Resolution and all connection attempts share one deadline. The resolved addresses are
+			raced as described in RFC 8305: a further attempt is started every 250 ms or as soon as
+			the previous one failed, the first established connection wins.
+		*/
+		auto netHelper_base::connect_socket(tcp::socket& socket) -> void {
+			const auto deadline = this->deadline_after(this->timeout);
+			const auto endpoints = this->resolve(deadline);
+
+			std::vector<std::unique_ptr<tcp::socket>> attempts;
+			attempts.reserve(endpoints.size());
+
+			boost::asio::steady_timer delay(*this->io_context);
+
+			size_t outstanding{0};
+			size_t running{0};
+			tcp::socket* winner{nullptr};
+			boost::system::error_code last_error = boost::asio::error::host_not_found;
+
+			std::function<void()> start_next = [&]() {
+				if (winner != nullptr || attempts.size() >= endpoints.size()) {
+					return;
+				}
+
+				auto* a = attempts.emplace_back(std::make_unique<tcp::socket>(*this->io_context)).get();
+
+				++outstanding;
+				++running;
+
+				a->async_connect(endpoints[attempts.size() - 1], [&, a](const boost::system::error_code& error) {
+					--outstanding;
+					--running;
+
+					if (!error) {
+						if (winner == nullptr) {
+							winner = a;
+						}
+					} else if (error != boost::asio::error::operation_aborted) {
+						last_error = error;
+						start_next();
+					}
+				});
+
+				++outstanding;
+				delay.expires_after(connection_attempt_delay);
+				delay.async_wait([&](const boost::system::error_code& error) {
+					--outstanding;
+
+					if (!error) {
+						start_next();
+					}
+				});
+			};
+
+			if (this->io_context->stopped()) {
+				this->io_context->restart();
+			}
+
+			start_next();
+
+			while (winner == nullptr && (running > 0 || attempts.size() < endpoints.size()) &&
+				   this->io_context->run_one_until(deadline) != 0u) {}
+
+			/*
+			 * stop the losers and wait for their handlers, they reference this stack frame
+			 */
+			delay.cancel();
+
+			for (auto& a : attempts) {
+				if (a.get() != winner) {
+					boost::system::error_code ec;
+					a->close(ec);
+				}
+			}
+
+			if (this->io_context->stopped()) {
+				this->io_context->restart();
+			}
+
+			while (outstanding > 0 && this->io_context->run_one() != 0u) {}
+
+			if (winner == nullptr) {
+				{
+					const std::lock_guard<std::mutex> lock(dns_cache_mtx);
+					dns_cache.erase(fmt::format("{}:{}", this->conn_target, this->conn_port));
+				}
+
+				if (std::chrono::steady_clock::now() >= deadline) {
+					this->stats.add(&metrics_snapshot::timeouts);
+					throw boost::system::system_error(boost::asio::error::timed_out, "connect");
+				}
+
+				throw boost::system::system_error(last_error, "connect");
+			}
+
+			socket = std::move(*winner);
+		}
+
+		netHelperTCP::netHelperTCP(std::string conn_target, std::string conn_port, bool use_msgpack, bool silent) 
+			: s(tcp::socket(*this->io_context)),
+			netHelper_base(std::move(conn_target), std::move(conn_port), use_msgpack, silent)
+		{}
+
+		netHelperTCP::netHelperTCP(netHelperTCP&& src) : netHelper_base(std::move(src)), s(std::move(src.s)) {}
+
+		auto netHelperTCP::operator=(netHelperTCP&& src) -> netHelperTCP& {
+			if (this == &src) {
+				return *this;
+			}
+
+			// the current socket still refers to the previous io_context until it is replaced
+			const auto previous = this->io_context;
+
+			netHelper_base::operator=(std::move(src));
+			this->s = std::move(src.s);
+
+			return *this;
+		}
+
+		netHelperTCP::~netHelperTCP() noexcept {
+			this->stop_subscription();
+		}
+		
+		/*!
+			@brief	connects socket
+			@return	Returns 0 on success, != 0 for errors.
+		*/
+		auto netHelperTCP::connect() -> int {
+			if (this->connected) {
+				return 1;
+			}
+
+			const auto start = metrics_recorder::start();
+
+			this->connect_socket(this->s);
+
+			this->stats.record(&metrics_snapshot::connect, start);
+
+			this->connected = true;
+
+			return 0;
+		}
+
+		void netHelperTCP::disconnect() {
+			if (!this->connected) {
+				return;
+			}
+
+			this->stop_subscription();
+
+			const std::lock_guard<std::mutex> lock(this->sock_mtx);
+			this->drop_connection();
+		}
+
+		auto netHelperTCP::shutdown_socket() -> void {
+			// the peer may have closed the connection already
+			boost::system::error_code ec;
+			this->s.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+		}
+
+		auto netHelperTCP::send(const std::string& data) -> int {
+			if (!this->connected) {
+				return -1;
+			}
+
+			size_t size{0};
+
+			boost::optional<boost::system::error_code> result;
+			boost::asio::async_write(this->s, boost::asio::buffer(data, data.size()),
+									[&result, &size](const boost::system::error_code& error, size_t length) {
+										result.reset(error);
+										size = length;
+									});
+
+			const auto ec = this->run_io(result, this->timeout);
+
+			if (ec) {
+				throw boost::system::system_error(ec);
+			}
+			
+			this->record_transfer(&metrics_snapshot::bytes_sent, size);
+
+			return static_cast<int>(size);
+		}
+
+		auto netHelperTCP::recv(void * buffer, size_t read_size) -> int {
+			if (!this->connected) {
+				return -1;
+			}
+
+			// everything is buffered already, no need to involve the io_context
+			if (this->s.available() >= read_size) {
+				const auto size = boost::asio::read(this->s, boost::asio::buffer(buffer, read_size));
+				this->record_transfer(&metrics_snapshot::bytes_received, size);
+
+				return static_cast<int>(size);
+			}
+
+			size_t size{0};
+
+			boost::optional<boost::system::error_code> result;
+			boost::asio::async_read(this->s, boost::asio::buffer(buffer, read_size),
+									[&result, &size](const boost::system::error_code& error, size_t length) {
+										result.reset(error);
+										size = length;
+									});
+
+			const auto ec = this->run_io(result, this->timeout);
+
+			if (ec) {
+				throw boost::system::system_error(ec);
 			}
 
-			return 0;
+			this->record_transfer(&metrics_snapshot::bytes_received, size);
+
+			return static_cast<int>(size);
 		}
 
-		auto netHelper_base::getCommandReturnPayload(const std::string& command, const json& payload, int api_version) -> json {
-			json j;
-			const auto retval = this->send_command(command, j, payload, api_version);
+		auto netHelperTCP::cancel_io() -> void {
+			this->s.cancel();
+		}
 
-			if (retval == 0) {
-				throw std::runtime_error("unknown error");
+		namespace {
+			auto remaining_ms(std::chrono::steady_clock::time_point deadline) -> unsigned int {
+				const auto remaining = deadline - std::chrono::steady_clock::now();
+
+				if (remaining <= std::chrono::steady_clock::duration::zero()) {
+					return 0;
+				}
+
+				return static_cast<unsigned int>(std::chrono::ceil<std::chrono::milliseconds>(remaining).count());
 			}
 
-			if (!is_json_object(j, "payload")) {
-				return {};
+			/*
+			 * The reactor can report a socket readable although the data was consumed by a
+			 * synchronous read in the meantime, recv() would then block until the timeout. A peek
+			 * tells that apart from new data or a closed connection (which recv() reports).
+			 */
+			auto stale_readiness(int fd) -> bool {
+				std::array<char, 1> byte{};
+
+				return ::recv(fd, byte.data(), byte.size(), MSG_PEEK | MSG_DONTWAIT) < 0 &&
+					   (errno == EAGAIN || errno == EWOULDBLOCK);
 			}
+		}  // namespace
 
-			auto &return_payload = j.at("payload");
+		/*!
+			@brief	waits until data can be read from the socket without consuming it
+			@return	Returns true if data is available, false on timeout.
+		*/
+		auto netHelperTCP::wait_readable(unsigned int timeout_ms) -> bool {
+			if (!this->connected) {
+				return false;
+			}
 
-			if (is_json_string(return_payload, "error")) {
-				throw std::runtime_error(return_payload.at("error").get<std::string>());
+			if (this->s.available() > 0) {
+				return true;
 			}
 
-			return return_payload;
-		}
+			const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
 
-		auto netHelper_base::is_connected() const -> bool {
-			return this->connected;
-		}
+			while (true) {
+				boost::optional<boost::system::error_code> result;
+				this->s.async_wait(tcp::socket::wait_read,
+								   [&result](const boost::system::error_code& error) { result.reset(error); });
 
-		/*!
-			@brief	connects socket
-			@return	Returns 0 on success, != 0 for errors.
-		*/
-		auto netHelper_base::connect() -> int {
-			return 0;
-		}
+				const auto ec = this->run_io(result, remaining_ms(deadline), true);
 
-		void netHelper_base::disconnect() {}
+				if (ec == boost::asio::error::operation_aborted) {
+					return false;
+				}
 
-		auto netHelper_base::send(const char * data) -> int {
-			return this->send(std::string(data));
-		}
+				if (ec) {
+					throw boost::system::system_error(ec);
+				}
 
-		auto netHelper_base::send(const std::vector<uint8_t>& data) -> int {
-			const std::string s(data.begin(), data.end());
-			return this->send(s);
+				if (!stale_readiness(this->s.native_handle())) {
+					return true;
+				}
+			}
 		}
 
-		auto netHelper_base::send(const std::string&  /*data*/) -> int {
-			return 0;
+		netHelperUnix::netHelperUnix(std::string socket_path, bool use_msgpack, bool silent)
+			: netHelper_base(std::move(socket_path), "", use_msgpack, silent), s(*this->io_context) {}
+
+		netHelperUnix::netHelperUnix(netHelperUnix&& src) : netHelper_base(std::move(src)), s(std::move(src.s)) {}
+
+		auto netHelperUnix::operator=(netHelperUnix&& src) -> netHelperUnix& {
+			if (this == &src) {
+				return *this;
+			}
+
+			// the current socket still refers to the previous io_context until it is replaced
+			const auto previous = this->io_context;
+
+			netHelper_base::operator=(std::move(src));
+			this->s = std::move(src.s);
+
+			return *this;
 		}
 
-		auto netHelper_base::recv(void *  /*buffer*/, size_t  /*read_size*/) -> int {
-			return 0;
+		netHelperUnix::~netHelperUnix() noexcept {
+			this->stop_subscription();
 		}
 
-		netHelperTCP::netHelperTCP(std::string conn_target, std::string conn_port, bool use_msgpack, bool silent) 
-			: s(tcp::socket(this->io_context)),
-			netHelper_base(std::move(conn_target), std::move(conn_port), use_msgpack, silent)
-		{}
-		
 		/*!
 			@brief	connects socket
 			@return	Returns 0 on success, != 0 for errors.
 		*/
-		auto netHelperTCP::connect() -> int {
+		auto netHelperUnix::connect() -> int {
 			if (this->connected) {
 				return 1;
 			}
 
-			tcp::resolver resolver(io_context);
-			const tcp::resolver::query query(this->conn_target, this->conn_port);
-			const tcp::resolver::iterator iterator = resolver.resolve(query);
+			const auto start = metrics_recorder::start();
 
-			boost::optional<boost::system::error_code> timer_result;
-			boost::asio::deadline_timer timer(this->io_context);
-			timer.expires_from_now(boost::posix_time::milliseconds(this->timeout));
-			timer.async_wait([&timer_result](const boost::system::error_code& error) { timer_result.reset(error); });
+			// a socket left over from a previous connection can not be connected again
+			boost::system::error_code close_ec;
+			this->s.close(close_ec);
 
 			boost::optional<boost::system::error_code> result;
-			boost::asio::async_connect(this->s, iterator,
-									[this, &result](const boost::system::error_code& error,
-													const tcp::resolver::iterator& /*endpoint*/) { result.reset(error); });
+			this->s.async_connect(boost::asio::local::stream_protocol::endpoint(this->conn_target),
+								  [&result](const boost::system::error_code& error) { result.reset(error); });
 
-			this->io_context.reset();
-			while (this->io_context.run_one() != 0u) {
-				if (result) {
-					timer.cancel();
-				} else if (timer_result) {
-					this->s.cancel();
-				}
-			}
+			const auto ec = this->run_io(result, this->timeout);
 
-			if (*result) {
-				throw boost::system::system_error(*result);
+			if (ec) {
+				throw boost::system::system_error(ec);
 			}
 
+			this->stats.record(&metrics_snapshot::connect, start);
+
 			this->connected = true;
 
 			return 0;
 		}
 
-		void netHelperTCP::disconnect() {
+		void netHelperUnix::disconnect() {
 			if (!this->connected) {
 				return;
 			}
 
-			const std::lock_guard<std::mutex> lock(this->sock_mtx);
+			this->stop_subscription();
 
-			this->s.shutdown(boost::asio::ip::tcp::socket::shutdown_both);
+			const std::lock_guard<std::mutex> lock(this->sock_mtx);
+			this->drop_connection();
+		}
 
-			this->connected = false;
+		auto netHelperUnix::shutdown_socket() -> void {
+			// the peer may have closed the connection already
+			boost::system::error_code ec;
+			this->s.shutdown(boost::asio::local::stream_protocol::socket::shutdown_both, ec);
 		}
 
-		auto netHelperTCP::send(const std::string& data) -> int {
+		auto netHelperUnix::send(const std::string& data) -> int {
 			if (!this->connected) {
 				return -1;
 			}
 
-			boost::optional<boost::system::error_code> timer_result;
-			boost::asio::deadline_timer timer(this->io_context);
-			timer.expires_from_now(boost::posix_time::milliseconds(this->timeout));
-			timer.async_wait([&timer_result](const boost::system::error_code& error) { timer_result.reset(error); });
-
 			size_t size{0};
 
 			boost::optional<boost::system::error_code> result;
@@ -379,31 +1868,29 @@ namespace bestsens {
 										size = length;
 									});
 
-			this->io_context.reset();
-			while (this->io_context.run_one() != 0u) {
-				if (result) {
-					timer.cancel();
-				} else if (timer_result) {
-					this->s.cancel();
-				}
-			}
+			const auto ec = this->run_io(result, this->timeout);
 
-			if (*result) {
-				throw boost::system::system_error(*result);
+			if (ec) {
+				throw boost::system::system_error(ec);
 			}
-			
+
+			this->record_transfer(&metrics_snapshot::bytes_sent, size);
+
 			return static_cast<int>(size);
 		}
 
-		auto netHelperTCP::recv(void * buffer, size_t read_size) -> int {
+		auto netHelperUnix::recv(void * buffer, size_t read_size) -> int {
 			if (!this->connected) {
 				return -1;
 			}
 
-			boost::optional<boost::system::error_code> timer_result;
-			boost::asio::deadline_timer timer(this->io_context);
-			timer.expires_from_now(boost::posix_time::milliseconds(this->timeout));
-			timer.async_wait([&timer_result](const boost::system::error_code& error) { timer_result.reset(error); });
+			// everything is buffered already, no need to involve the io_context
+			if (this->s.available() >= read_size) {
+				const auto size = boost::asio::read(this->s, boost::asio::buffer(buffer, read_size));
+				this->record_transfer(&metrics_snapshot::bytes_received, size);
+
+				return static_cast<int>(size);
+			}
 
 			size_t size{0};
 
@@ -414,29 +1901,71 @@ namespace bestsens {
 										size = length;
 									});
 
-			this->io_context.reset();
-			while (this->io_context.run_one() != 0u) {
-				if (result) {
-					timer.cancel();
-				} else if (timer_result) {
-					this->s.cancel();
-				}
-			}
+			const auto ec = this->run_io(result, this->timeout);
 
-			if (*result) {
-				throw boost::system::system_error(*result);
+			if (ec) {
+				throw boost::system::system_error(ec);
 			}
 
+			this->record_transfer(&metrics_snapshot::bytes_received, size);
+
 			return static_cast<int>(size);
 		}
 
+		auto netHelperUnix::cancel_io() -> void {
+			this->s.cancel();
+		}
+
+		/*!
+			@brief	waits until data can be read from the socket without consuming it
+			@return	Returns true if data is available, false on timeout.
+		*/
+		auto netHelperUnix::wait_readable(unsigned int timeout_ms) -> bool {
+			if (!this->connected) {
+				return false;
+			}
+
+			if (this->s.available() > 0) {
+				return true;
+			}
+
+			const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+			while (true) {
+				boost::optional<boost::system::error_code> result;
+				this->s.async_wait(boost::asio::local::stream_protocol::socket::wait_read,
+								   [&result](const boost::system::error_code& error) { result.reset(error); });
+
+				const auto ec = this->run_io(result, remaining_ms(deadline), true);
+
+				if (ec == boost::asio::error::operation_aborted) {
+					return false;
+				}
+
+				if (ec) {
+					throw boost::system::system_error(ec);
+				}
+
+				if (!stale_readiness(this->s.native_handle())) {
+					return true;
+				}
+			}
+		}
+
 		netHelperSSL::netHelperSSL(std::string conn_target, std::string conn_port, bool use_msgpack, bool silent)
 			: ssl_ctx(boost::asio::ssl::context(boost::asio::ssl::context::sslv23)),
-			s(boost::asio::ssl::stream<tcp::socket>(this->io_context, this->ssl_ctx)),
+			s(boost::asio::ssl::stream<tcp::socket>(*this->io_context, this->ssl_ctx)),
 			netHelper_base(std::move(conn_target), std::move(conn_port), use_msgpack, silent) {
 			this->s.set_verify_mode(boost::asio::ssl::verify_none);
 		}
 
+		netHelperSSL::netHelperSSL(netHelperSSL&& src)
+			: netHelper_base(std::move(src)), ssl_ctx(std::move(src.ssl_ctx)), s(std::move(src.s)) {}
+
+		netHelperSSL::~netHelperSSL() noexcept {
+			this->stop_subscription();
+		}
+
 		/*!
 			@brief	connects socket
 			@return	Returns 0 on success, != 0 for errors.
@@ -446,32 +1975,11 @@ namespace bestsens {
 				return 1;
 			}
 
-			tcp::resolver resolver(io_context);
-			const tcp::resolver::query query(this->conn_target, this->conn_port);
-			const tcp::resolver::iterator iterator = resolver.resolve(query);
+			const auto start = metrics_recorder::start();
 
-			boost::optional<boost::system::error_code> timer_result;
-			boost::asio::deadline_timer timer(this->io_context);
-			timer.expires_from_now(boost::posix_time::milliseconds(this->timeout));
-			timer.async_wait([&timer_result](const boost::system::error_code& error) { timer_result.reset(error); });
-
-			boost::optional<boost::system::error_code> result;
-			boost::asio::async_connect(this->s.lowest_layer(), iterator,
-									[this, &result](const boost::system::error_code& error,
-													const tcp::resolver::iterator& /*endpoint*/) { result.reset(error); });
-
-			this->io_context.reset();
-			while (this->io_context.run_one() != 0u) {
-				if (result) {
-					timer.cancel();
-				} else if (timer_result) {
-					this->s.lowest_layer().cancel();
-				}
-			}
+			this->connect_socket(this->s.next_layer());
 
-			if (*result) {
-				throw boost::system::system_error(*result);
-			}
+			this->stats.record(&metrics_snapshot::connect, start);
 
 			this->handshake();
 
@@ -481,27 +1989,19 @@ namespace bestsens {
 		}
 
 		auto netHelperSSL::handshake() -> void {
-			boost::optional<boost::system::error_code> timer_result;
-			boost::asio::deadline_timer timer(this->io_context);
-			timer.expires_from_now(boost::posix_time::milliseconds(this->timeout));
-			timer.async_wait([&timer_result](const boost::system::error_code& error) { timer_result.reset(error); });
+			const auto start = metrics_recorder::start();
 
 			boost::optional<boost::system::error_code> result;
 			this->s.async_handshake(boost::asio::ssl::stream_base::client,
 									[this, &result](const boost::system::error_code& error) { result.reset(error); });
 
-			this->io_context.reset();
-			while (this->io_context.run_one() != 0u) {
-				if (result) {
-					timer.cancel();
-				} else if (timer_result) {
-					this->s.lowest_layer().cancel();
-				}
-			}
+			const auto ec = this->run_io(result, this->timeout);
 
-			if (*result) {
-				throw boost::system::system_error(*result);
+			if (ec) {
+				throw boost::system::system_error(ec);
 			}
+
+			this->stats.record(&metrics_snapshot::handshake, start);
 		}
 
 		void netHelperSSL::disconnect() {
@@ -509,11 +2009,16 @@ namespace bestsens {
 				return;
 			}
 
-			const std::lock_guard<std::mutex> lock(this->sock_mtx);
+			this->stop_subscription();
 
-			this->s.lowest_layer().shutdown(boost::asio::ip::tcp::socket::shutdown_both);
+			const std::lock_guard<std::mutex> lock(this->sock_mtx);
+			this->drop_connection();
+		}
 
-			this->connected = false;
+		auto netHelperSSL::shutdown_socket() -> void {
+			// the peer may have closed the connection already
+			boost::system::error_code ec;
+			this->s.lowest_layer().shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
 		}
 
 		auto netHelperSSL::send(const std::string& data) -> int {
@@ -521,11 +2026,6 @@ namespace bestsens {
 				return -1;
 			}
 
-			boost::optional<boost::system::error_code> timer_result;
-			boost::asio::deadline_timer timer(this->io_context);
-			timer.expires_from_now(boost::posix_time::milliseconds(this->timeout));
-			timer.async_wait([&timer_result](const boost::system::error_code& error) { timer_result.reset(error); });
-
 			size_t size{0};
 
 			boost::optional<boost::system::error_code> result;
@@ -535,19 +2035,14 @@ namespace bestsens {
 										size = length;
 									});
 
-			this->io_context.reset();
-			while (this->io_context.run_one() != 0u) {
-				if (result) {
-					timer.cancel();
-				} else if (timer_result) {
-					this->s.lowest_layer().cancel();
-				}
-			}
+			const auto ec = this->run_io(result, this->timeout);
 
-			if (*result) {
-				throw boost::system::system_error(*result);
+			if (ec) {
+				throw boost::system::system_error(ec);
 			}
 
+			this->record_transfer(&metrics_snapshot::bytes_sent, size);
+
 			return static_cast<int>(size);
 		}
 
@@ -556,11 +2051,6 @@ namespace bestsens {
 				return -1;
 			}
 
-			boost::optional<boost::system::error_code> timer_result;
-			boost::asio::deadline_timer timer(this->io_context);
-			timer.expires_from_now(boost::posix_time::milliseconds(this->timeout));
-			timer.async_wait([&timer_result](const boost::system::error_code& error) { timer_result.reset(error); });
-
 			size_t size{0};
 
 			boost::optional<boost::system::error_code> result;
@@ -570,25 +2060,180 @@ namespace bestsens {
 										size = length;
 									});
 
-			this->io_context.reset();
-			while (this->io_context.run_one() != 0u) {
-				if (result) {
-					timer.cancel();
-				} else if (timer_result) {
-					this->s.lowest_layer().cancel();
-				}
-			}
+			const auto ec = this->run_io(result, this->timeout);
 
-			if (*result) {
-				throw boost::system::system_error(*result);
+			if (ec) {
+				throw boost::system::system_error(ec);
 			}
 
+			this->record_transfer(&metrics_snapshot::bytes_received, size);
+
 			return static_cast<int>(size);
 		}
+
+		auto netHelperSSL::cancel_io() -> void {
+			this->s.lowest_layer().cancel();
+		}
+
+		/*!
+			@brief	waits until data can be read from the socket without consuming it
+			@return	Returns true if data is available, false on timeout.
+		*/
+		auto netHelperSSL::wait_readable(unsigned int timeout_ms) -> bool {
+			if (!this->connected) {
+				return false;
+			}
+
+			if (SSL_pending(this->s.native_handle()) > 0 || this->s.lowest_layer().available() > 0) {
+				return true;
+			}
+
+			const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+			while (true) {
+				boost::optional<boost::system::error_code> result;
+				this->s.lowest_layer().async_wait(tcp::socket::wait_read,
+												[&result](const boost::system::error_code& error) { result.reset(error); });
+
+				const auto ec = this->run_io(result, remaining_ms(deadline), true);
+
+				if (ec == boost::asio::error::operation_aborted) {
+					return false;
+				}
+
+				if (ec) {
+					throw boost::system::system_error(ec);
+				}
+
+				if (!stale_readiness(this->s.lowest_layer().native_handle())) {
+					return true;
+				}
+			}
+		}
 	}  // namespace detail
 
+	namespace {
+		thread_local command_priority current_priority = command_priority::normal;
+	}  // namespace
+
+	command_priority_scope::command_priority_scope(command_priority priority)
+		: previous(std::exchange(current_priority, priority)) {}
+
+	command_priority_scope::~command_priority_scope() {
+		current_priority = this->previous;
+	}
+
+	auto command_priority_scope::current() -> command_priority {
+		return current_priority;
+	}
+
+	prepared_command::prepared_command(std::string command, const json& payload, int api_version, bool use_msgpack)
+		: name(std::move(command)), api_version(api_version), use_msgpack(use_msgpack) {
+		this->set_payload(payload);
+	}
+
+	auto prepared_command::set_payload(const json& payload) -> void {
+		// like send_command() a payload is only added if it is an object
+		if (payload.is_object() != this->has_payload || this->request.empty()) {
+			this->encode_envelope(payload.is_object());
+		}
+
+		if (!this->has_payload) {
+			return;
+		}
+
+		this->request.resize(this->prefix_size);
+
+		if (this->use_msgpack) {
+			json::to_msgpack(payload, this->request);
+			this->request.append(detail::request_delimiter);
+		} else {
+			this->finish(payload.dump());
+		}
+	}
+
+	/*!
+		@brief	sets a payload that is already encoded in the format of the command
+	*/
+	auto prepared_command::set_encoded_payload(std::string_view payload) -> void {
+		if (!this->has_payload) {
+			this->encode_envelope(true);
+		}
+
+		this->request.resize(this->prefix_size);
+		this->finish(payload);
+	}
+
+	auto prepared_command::command() const -> const std::string& {
+		return this->name;
+	}
+
+	auto prepared_command::is_msgpack() const -> bool {
+		return this->use_msgpack;
+	}
+
+	/*!
+		@brief	complete request including the delimiter
+	*/
+	auto prepared_command::encoded() const -> const std::string& {
+		return this->request;
+	}
+
+	/*
+	 * Encodes the envelope with a null payload. "payload" sorts last among the envelope keys, so
+	 * the encoding ends with the null value (and the closing brace for JSON): everything before it
+	 * is the prefix the payload is appended to.
+	 */
+	auto prepared_command::encode_envelope(bool with_payload) -> void {
+		json envelope = {{"command", this->name}};
+
+		if (this->api_version > 0) {
+			envelope["api"] = this->api_version;
+		}
+
+		if (with_payload) {
+			envelope["payload"] = nullptr;
+		}
+
+		this->request.clear();
+
+		if (this->use_msgpack) {
+			json::to_msgpack(envelope, this->request);
+		} else {
+			this->request = envelope.dump();
+		}
+
+		this->has_payload = with_payload;
+
+		if (!with_payload) {
+			this->request.append(detail::request_delimiter);
+			return;
+		}
+
+		this->prefix_size = this->request.size() - (this->use_msgpack ? 1 : std::string_view("null}").size());
+	}
+
+	auto prepared_command::finish(std::string_view payload) -> void {
+		this->request.append(payload);
+
+		if (!this->use_msgpack) {
+			this->request.push_back('}');
+		}
+
+		this->request.append(detail::request_delimiter);
+	}
+
+	/*!
+		@brief	creates a connection, a conn_target of "unix:<path>" selects a unix domain socket
+				(conn_port and use_ssl are ignored then)
+	*/
 	netHelper::netHelper(std::string conn_target, std::string conn_port, bool use_msgpack, bool silent, bool use_ssl) {
-		if (use_ssl) {
+		constexpr std::string_view unix_prefix = "unix:";
+
+		if (conn_target.starts_with(unix_prefix)) {
+			this->ptr = std::make_unique<detail::netHelperUnix>(conn_target.substr(unix_prefix.size()), use_msgpack,
+																silent);
+		} else if (use_ssl) {
 			this->ptr = std::make_unique<detail::netHelperSSL>(std::move(conn_target), std::move(conn_port),
 															   use_msgpack, silent);
 		} else {
@@ -601,6 +2246,10 @@ namespace bestsens {
 		return this->ptr->login(user_name, password, use_hash);
 	};
 
+	auto netHelper::relogin() -> int {
+		return this->ptr->relogin();
+	}
+
 	auto netHelper::is_logged_in() const -> int {
 		return this->ptr->is_logged_in();
 	};
@@ -622,10 +2271,46 @@ namespace bestsens {
 		return this->ptr->send_command(command, response, payload, api_version);
 	}
 
+	auto netHelper::send_command(const std::string& command, json::json_sax_t& sax, const json& payload,
+								 int api_version) -> int {
+		return this->ptr->send_command(command, sax, payload, api_version);
+	}
+
+	auto netHelper::send_command(const std::string& command, binary_response& response, const json& payload,
+								 int api_version) -> int {
+		return this->ptr->send_command(command, response, payload, api_version);
+	}
+
 	auto netHelper::getCommandReturnPayload(const std::string& command, const json& payload, int api_version) -> json {
 		return this->ptr->getCommandReturnPayload(command, payload, api_version);
 	}
 
+	auto netHelper::prepare(const std::string& command, const json& payload, int api_version) const
+		-> prepared_command {
+		return this->ptr->prepare(command, payload, api_version);
+	}
+
+	auto netHelper::send_command(const prepared_command& command, json& response) -> int {
+		return this->ptr->send_command(command, response);
+	}
+
+	auto netHelper::getCommandReturnPayload(const prepared_command& command) -> json {
+		return this->ptr->getCommandReturnPayload(command);
+	}
+
+	auto netHelper::subscribe(const std::string& command, subscription_callback callback, const json& payload,
+							  size_t queue_size, bool drop_oldest) -> json {
+		return this->ptr->subscribe(command, std::move(callback), payload, queue_size, drop_oldest);
+	}
+
+	auto netHelper::unsubscribe(const std::string& command) -> void {
+		this->ptr->unsubscribe(command);
+	}
+
+	auto netHelper::is_subscribed() const -> bool {
+		return this->ptr->is_subscribed();
+	}
+
 	[[deprecated]] auto netHelper::set_timeout(unsigned int timeout) -> void {
 		return this->ptr->set_timeout_ms(timeout * 1000);
 	}
@@ -634,10 +2319,42 @@ namespace bestsens {
 		return this->ptr->set_timeout_ms(timeout_ms);
 	}
 
+	auto netHelper::set_deadline(std::chrono::steady_clock::time_point deadline) -> void {
+		return this->ptr->set_deadline(deadline);
+	}
+
+	auto netHelper::enable_compression(size_t threshold) -> bool {
+		return this->ptr->enable_compression(threshold);
+	}
+
+	auto netHelper::is_compression_enabled() const -> bool {
+		return this->ptr->is_compression_enabled();
+	}
+
+	auto netHelper::metrics() const -> metrics_snapshot {
+		return this->ptr->metrics();
+	}
+
+	auto netHelper::set_bandwidth_limit(size_t bytes_per_second, size_t burst) -> void {
+		this->ptr->set_bandwidth_limit(bytes_per_second, burst);
+	}
+
 	auto netHelper::get_mutex() -> std::mutex& {
 		return this->ptr->get_mutex();
 	}
 
+	auto netHelper::set_dns_cache_ttl(std::chrono::seconds ttl) -> void {
+		detail::netHelper_base::set_dns_cache_ttl(ttl);
+	}
+
+	auto netHelper::get_dns_cache_ttl() -> std::chrono::seconds {
+		return detail::netHelper_base::get_dns_cache_ttl();
+	}
+
+	auto netHelper::clear_dns_cache() -> void {
+		detail::netHelper_base::clear_dns_cache();
+	}
+
 	auto netHelper::sha512(const std::string& input) -> std::string {
 		return detail::netHelper_base::sha512(input);
 	}
@@ -665,4 +2382,66 @@ namespace bestsens {
 	auto netHelper::recv(void* buffer, size_t read_size) -> int {
 		return this->ptr->recv(buffer, read_size);
 	}
+
+	auto fan_out(const std::vector<fanout_endpoint>& endpoints, const std::string& command,
+				 const fanout_callback& callback, const json& payload, fanout_options options) -> void {
+		std::atomic<size_t> next{0};
+		std::mutex callback_mtx;
+		std::exception_ptr callback_error;
+
+		const auto worker = [&]() {
+			for (auto index = next++; index < endpoints.size(); index = next++) {
+				const auto& endpoint = endpoints[index];
+
+				fanout_result result;
+				result.index = index;
+
+				try {
+					netHelper socket(endpoint.target, endpoint.port, endpoint.use_msgpack, true, endpoint.use_ssl);
+					socket.set_timeout_ms(options.timeout_ms);
+					socket.set_deadline(std::chrono::steady_clock::now() + std::chrono::milliseconds(options.timeout_ms));
+					socket.connect();
+
+					if (!endpoint.user_name.empty() && socket.login(endpoint.user_name, endpoint.password) <= 0) {
+						result.error = "login failed";
+					} else {
+						result.payload = socket.getCommandReturnPayload(command, payload, options.api_version);
+					}
+				} catch (const std::exception& e) {
+					result.error = e.what();
+				}
+
+				const std::lock_guard<std::mutex> lock(callback_mtx);
+
+				if (callback_error) {
+					return;
+				}
+
+				// the first exception of the callback ends the fan out and is rethrown after all workers finished
+				try {
+					callback(result);
+				} catch (...) {
+					callback_error = std::current_exception();
+					next = endpoints.size();
+				}
+			}
+		};
+
+		const auto thread_count = std::min(std::max<size_t>(options.concurrency, 1), endpoints.size());
+
+		std::vector<std::thread> threads;
+		threads.reserve(thread_count);
+
+		for (size_t i = 0; i < thread_count; ++i) {
+			threads.emplace_back(worker);
+		}
+
+		for (auto& t : threads) {
+			t.join();
+		}
+
+		if (callback_error) {
+			std::rethrow_exception(callback_error);
+		}
+	}
 }
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "allocation_counter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+	// per thread, so allocations of mock servers running in the background are not counted
+	thread_local size_t counter{0};
+
+	auto allocate(size_t size) -> void* {
+		++counter;
+
+		if (void* p = std::malloc(size == 0 ? 1 : size)) {
+			return p;
+		}
+
+		throw std::bad_alloc();
+	}
+
+	auto allocate(size_t size, std::align_val_t alignment) -> void* {
+		++counter;
+
+		const auto align = static_cast<size_t>(alignment);
+
+		// aligned_alloc requires a non zero size that is a multiple of the alignment
+		const auto padded = size == 0 ? align : (size + align - 1) / align * align;
+
+		if (void* p = std::aligned_alloc(align, padded)) {
+			return p;
+		}
+
+		throw std::bad_alloc();
+	}
+}  // namespace
+
+auto allocation_counter::allocations() -> size_t {
+	return counter;
+}
+
+auto operator new(size_t size) -> void* {
+	return allocate(size);
+}
+
+auto operator new[](size_t size) -> void* {
+	return allocate(size);
+}
+
+auto operator new(size_t size, std::align_val_t alignment) -> void* {
+	return allocate(size, alignment);
+}
+
+auto operator new[](size_t size, std::align_val_t alignment) -> void* {
+	return allocate(size, alignment);
+}
+
+auto operator new(size_t size, const std::nothrow_t&) noexcept -> void* {
+	try {
+		return allocate(size);
+	} catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+auto operator new[](size_t size, const std::nothrow_t&) noexcept -> void* {
+	try {
+		return allocate(size);
+	} catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+auto operator delete(void* p) noexcept -> void {
+	std::free(p);
+}
+
+auto operator delete[](void* p) noexcept -> void {
+	std::free(p);
+}
+
+auto operator delete(void* p, size_t) noexcept -> void {
+	std::free(p);
+}
+
+auto operator delete[](void* p, size_t) noexcept -> void {
+	std::free(p);
+}
+
+auto operator delete(void* p, std::align_val_t) noexcept -> void {
+	std::free(p);
+}
+
+auto operator delete[](void* p, std::align_val_t) noexcept -> void {
+	std::free(p);
+}
+
+auto operator delete(void* p, size_t, std::align_val_t) noexcept -> void {
+	std::free(p);
+}
+
+auto operator delete[](void* p, size_t, std::align_val_t) noexcept -> void {
+	std::free(p);
+}
+
+auto operator delete(void* p, const std::nothrow_t&) noexcept -> void {
+	std::free(p);
+}
+
+auto operator delete[](void* p, const std::nothrow_t&) noexcept -> void {
+	std::free(p);
+}
@@ -0,0 +1,40 @@
+/*
+ * allocation_counter.hpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#ifndef ALLOCATION_COUNTER_HPP_
+#define ALLOCATION_COUNTER_HPP_
+
+#include <cstddef>
+
+namespace allocation_counter {
+	/*!
+	 * @brief number of calls to the global operator new made by the calling thread so far
+	 *
+	 * counted by the replacement operators in allocation_counter.cpp, which has to be linked into
+	 * the executable
+	 */
+	auto allocations() -> size_t;
+
+	/*!
+	 * @brief average number of allocations per call of `f`
+	 *
+	 * `f` is called once to warm up caches and reserve capacity before counting
+	 */
+	template <typename Function>
+	auto per_op(Function&& f, size_t iterations = 100) -> double {
+		f();
+
+		const auto before = allocations();
+		for (size_t i = 0; i < iterations; ++i) {
+			f();
+		}
+
+		return static_cast<double>(allocations() - before) / static_cast<double>(iterations);
+	}
+}  // namespace allocation_counter
+
+#endif /* ALLOCATION_COUNTER_HPP_ */
@@ -0,0 +1,559 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "allocation_counter.hpp"
+#include "bone_helper/jsonArena.hpp"
+#include "bone_helper/jsonHelper.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_all.hpp"
+#include "fmt/format.h"
+
+using json = nlohmann::json;
+
+namespace {
+	/*
+	 * statistics tree with `width` children per level and numeric leaves at `depth`
+	 */
+	auto make_tree(size_t depth, size_t width, double value) -> json {
+		if (depth == 0) {
+			return value;
+		}
+
+		json node = json::object();
+
+		for (size_t i = 0; i < width; ++i) {
+			node[fmt::format("node_{}", i)] = make_tree(depth - 1, width, value + static_cast<double>(i));
+		}
+
+		return node;
+	}
+
+	/*
+	 * arithmetic_merge_json before it was built on the in-place variant, kept as a reference
+	 */
+	template <typename Function>
+	auto copying_merge_json(const json& from, json to, Function operation) -> json {
+		if (from.is_structured()) {
+			if (from.type() != to.type()) {
+				return to;
+			}
+
+			size_t i{0};
+			for (auto it = from.cbegin(); it != from.cend(); ++it, ++i) {
+				if (from.is_object()) {
+					if (!it.value().is_null()) {
+						to[it.key()] = copying_merge_json(it.value(), to.at(it.key()), operation);
+					}
+				} else {
+					if (i >= to.size()) {
+						break;
+					}
+
+					to[i] = copying_merge_json(it.value(), to.at(i), operation);
+				}
+			}
+
+			return to;
+		}
+
+		if (from.is_number() && to.is_number()) {
+			if (from.is_number_integer() && to.is_number_integer()) {
+				return json(operation(from.get<long>(), to.get<long>()));
+			}
+
+			return json(operation(from.get<double>(), to.get<double>()));
+		}
+
+		return to;
+	}
+}  // namespace
+
+TEST_CASE("jsonHelper arithmetic merge", "[benchmark][jsonHelper]") {
+	for (const auto& [depth, width] : {std::pair<size_t, size_t>{2, 8}, {4, 8}, {6, 4}}) {
+		const auto sample = make_tree(depth, width, 1.0);
+		const auto name = fmt::format("depth {} width {}", depth, width);
+
+		auto accumulator = make_tree(depth, width, 0.0);
+
+		BENCHMARK(fmt::format("copying add, {}", name)) {
+			accumulator = copying_merge_json(sample, accumulator, [](auto a, auto b) { return a + b; });
+			return accumulator.size();
+		};
+
+		BENCHMARK(fmt::format("arithmetic_add_json, {}", name)) {
+			accumulator = bestsens::arithmetic_add_json(sample, accumulator);
+			return accumulator.size();
+		};
+
+		BENCHMARK(fmt::format("arithmetic_add_json_inplace, {}", name)) {
+			bestsens::arithmetic_add_json_inplace(sample, accumulator);
+			return accumulator.size();
+		};
+
+		// from / to, alternates between two values instead of running into denormals
+		auto quotient = make_tree(depth, width, 2.0);
+
+		BENCHMARK(fmt::format("arithmetic_div_json, {}", name)) {
+			quotient = bestsens::arithmetic_div_json(sample, quotient);
+			return quotient.size();
+		};
+
+		BENCHMARK(fmt::format("arithmetic_div_json_inplace, {}", name)) {
+			bestsens::arithmetic_div_json_inplace(sample, quotient);
+			return quotient.size();
+		};
+	}
+}
+
+TEST_CASE("jsonHelper arithmetic merge spectrum", "[benchmark][jsonHelper]") {
+	constexpr size_t bins = 4096;
+
+	const json sample = {{"spectrum", std::vector<double>(bins, 1.0)}};
+	json accumulator = {{"spectrum", std::vector<double>(bins, 0.0)}};
+
+	// a single integer bin disables the numeric array fast path
+	json mixed_sample = sample;
+	mixed_sample["spectrum"][0] = 1;
+
+	BENCHMARK("arithmetic_add_json_inplace, mixed 4096 bins") {
+		bestsens::arithmetic_add_json_inplace(mixed_sample, accumulator);
+		return accumulator.size();
+	};
+
+	BENCHMARK("arithmetic_add_json_inplace, float 4096 bins") {
+		bestsens::arithmetic_add_json_inplace(sample, accumulator);
+		return accumulator.size();
+	};
+
+	BENCHMARK("arithmetic_add_json, float 4096 bins") {
+		accumulator = bestsens::arithmetic_add_json(sample, accumulator);
+		return accumulator.size();
+	};
+}
+
+TEST_CASE("jsonHelper accumulator", "[benchmark][jsonHelper]") {
+	for (const auto& [depth, width] : {std::pair<size_t, size_t>{2, 8}, {4, 8}}) {
+		const auto sample = make_tree(depth, width, 1.0);
+		const auto name = fmt::format("depth {} width {}", depth, width);
+
+		auto tree = make_tree(depth, width, 0.0);
+		bestsens::json_accumulator accumulator(tree);
+
+		BENCHMARK(fmt::format("arithmetic_add_json_inplace, {}", name)) {
+			bestsens::arithmetic_add_json_inplace(sample, tree);
+			return tree.size();
+		};
+
+		BENCHMARK(fmt::format("json_accumulator::add, {}", name)) {
+			accumulator.add(sample);
+			return accumulator.count();
+		};
+
+		BENCHMARK(fmt::format("json_accumulator::mean, {}", name)) {
+			return accumulator.mean();
+		};
+	}
+}
+
+namespace {
+	struct device_config {
+		int port{0};
+		int timeout_ms{0};
+		int channels{0};
+		int buffer_size{0};
+		double interval{0.0};
+		double threshold_warning{0.0};
+		double threshold_alarm{0.0};
+		double scale{0.0};
+		bool enabled{false};
+		bool use_ssl{false};
+		std::string name{};
+		std::string location{};
+		std::string unit{};
+		std::string log_level{};
+	};
+
+	auto make_device_config(size_t padding) -> json {
+		json j = {{"port", 6450},
+				  {"timeout_ms", 2000},
+				  {"channels", 8},
+				  {"buffer_size", 65536},
+				  {"interval", 0.5},
+				  {"threshold_warning", 4.5},
+				  {"threshold_alarm", 7.1},
+				  {"scale", 1.0},
+				  {"enabled", true},
+				  {"use_ssl", false},
+				  {"name", "bearing monitor of the main drive"},
+				  {"location", "hall 3, line 2, position 14"},
+				  {"unit", "mm/s"},
+				  {"log_level", "info"}};
+
+		// members handled by other parts of the config loader
+		for (size_t i = 0; i < padding; ++i) {
+			j[fmt::format("other_{}", i)] = i;
+		}
+
+		return j;
+	}
+}  // namespace
+
+TEST_CASE("jsonHelper config binding", "[benchmark][jsonHelper]") {
+	bestsens::json_binding<device_config> binding;
+	binding.bind("port", &device_config::port, 6450)
+		.bind("timeout_ms", &device_config::timeout_ms, 1000)
+		.bind("channels", &device_config::channels, 4)
+		.bind("buffer_size", &device_config::buffer_size, 4096)
+		.bind("interval", &device_config::interval, 1.0)
+		.bind("threshold_warning", &device_config::threshold_warning, 4.5)
+		.bind("threshold_alarm", &device_config::threshold_alarm, 7.1)
+		.bind("scale", &device_config::scale, 1.0)
+		.bind("enabled", &device_config::enabled, true)
+		.bind("use_ssl", &device_config::use_ssl, false)
+		.bind("name", &device_config::name, std::string{})
+		.bind("location", &device_config::location, std::string{})
+		.bind("unit", &device_config::unit, std::string{"mm/s"})
+		.bind("log_level", &device_config::log_level, std::string{"warning"});
+
+	for (const size_t padding : {0, 50}) {
+		const auto j = make_device_config(padding);
+		device_config config;
+
+		BENCHMARK(fmt::format("checkedUpdateFromJSON, {} other members", padding)) {
+			bestsens::checkedUpdateFromJSON(j, "port", config.port, 6450);
+			bestsens::checkedUpdateFromJSON(j, "timeout_ms", config.timeout_ms, 1000);
+			bestsens::checkedUpdateFromJSON(j, "channels", config.channels, 4);
+			bestsens::checkedUpdateFromJSON(j, "buffer_size", config.buffer_size, 4096);
+			bestsens::checkedUpdateFromJSON(j, "interval", config.interval, 1.0);
+			bestsens::checkedUpdateFromJSON(j, "threshold_warning", config.threshold_warning, 4.5);
+			bestsens::checkedUpdateFromJSON(j, "threshold_alarm", config.threshold_alarm, 7.1);
+			bestsens::checkedUpdateFromJSON(j, "scale", config.scale, 1.0);
+			bestsens::checkedUpdateFromJSON(j, "enabled", config.enabled, true);
+			bestsens::checkedUpdateFromJSON(j, "use_ssl", config.use_ssl, false);
+			bestsens::checkedUpdateFromJSON(j, "name", config.name, std::string{});
+			bestsens::checkedUpdateFromJSON(j, "location", config.location, std::string{});
+			bestsens::checkedUpdateFromJSON(j, "unit", config.unit, std::string{"mm/s"});
+			bestsens::checkedUpdateFromJSON(j, "log_level", config.log_level, std::string{"warning"});
+			return config.port;
+		};
+
+		BENCHMARK(fmt::format("json_binding, {} other members", padding)) {
+			return binding.apply(j, config);
+		};
+	}
+}
+
+TEST_CASE("jsonHelper value access", "[benchmark][jsonHelper]") {
+	const auto j = make_device_config(50);
+
+	BENCHMARK("value_ig_type, present") {
+		return bestsens::value_ig_type(j, "timeout_ms", 1000);
+	};
+
+	BENCHMARK("value_ig_type, missing") {
+		return bestsens::value_ig_type(j, "missing", 1000);
+	};
+
+	// the type_error is thrown and caught inside
+	BENCHMARK("value_ig_type, wrong type") {
+		return bestsens::value_ig_type(j, "name", 1000);
+	};
+
+	BENCHMARK("value_ig_type, string") {
+		return bestsens::value_ig_type(j, "name", std::string{});
+	};
+
+	int timeout_ms{0};
+
+	BENCHMARK("checkedUpdateFromJSON, present") {
+		return bestsens::checkedUpdateFromJSON(j, "timeout_ms", timeout_ms, 1000);
+	};
+
+	BENCHMARK("checkedUpdateFromJSON, wrong type") {
+		return bestsens::checkedUpdateFromJSON(j, "name", timeout_ms, 1000);
+	};
+}
+
+TEST_CASE("jsonHelper filtered values", "[benchmark][jsonHelper]") {
+	json status = json::object();
+	for (size_t i = 0; i < 2000; ++i) {
+		status[fmt::format("value_{}", i)] = {{"value", static_cast<double>(i)}, {"unit", "mm/s"}};
+	}
+
+	for (const size_t size : {5, 50, 200}) {
+		std::vector<std::string> keys;
+		for (size_t i = 0; i < size; ++i) {
+			keys.push_back(fmt::format("value_{}", i * 7));
+		}
+
+		const bestsens::json_key_filter filter(keys);
+
+		// get_filtered_values before the lookup by key, kept as a reference
+		BENCHMARK(fmt::format("linear find, {} keys", size)) {
+			json result;
+
+			for (const auto& e : status.items()) {
+				if (std::find(keys.cbegin(), keys.cend(), e.key()) != keys.cend()) {
+					result[e.key()] = e.value();
+				}
+			}
+
+			return result;
+		};
+
+		BENCHMARK(fmt::format("vector filter, {} keys", size)) {
+			return bestsens::get_filtered_values(status, keys);
+		};
+
+		BENCHMARK(fmt::format("json_key_filter, {} keys", size)) {
+			return bestsens::get_filtered_values(status, filter);
+		};
+	}
+}
+
+namespace {
+	/*
+	 * merge_json before merge_json_inplace, kept as a reference
+	 */
+	auto flattening_merge_json(const json& a, const json& b) -> json {
+		try {
+			json result = a.flatten();
+			const json tmp = b.flatten();
+
+			for (auto it = tmp.begin(); it != tmp.end(); ++it) {
+				result[it.key()] = it.value();
+			}
+
+			return result.unflatten();
+		} catch (const json::exception&) {}
+
+		return a.is_structured() ? a : b;
+	}
+
+	/*
+	 * service configuration with `devices` entries of about 20 leaves each
+	 */
+	auto make_config(size_t devices, const std::string& name) -> json {
+		json config = {{"name", name}, {"log", {{"level", "info"}, {"file", "/var/log/service.log"}}}};
+
+		for (size_t i = 0; i < devices; ++i) {
+			config["devices"][fmt::format("device_{}", i)] = {
+				{"address", fmt::format("192.168.0.{}", i)},
+				{"port", 6450},
+				{"enabled", true},
+				{"limits", {{"warning", 4.5}, {"alarm", 7.1}, {"hysteresis", 0.2}}},
+				{"channels", {{{"name", "x"}, {"scale", 1.0}}, {{"name", "y"}, {"scale", 1.0}}, {{"name", "z"}, {"scale", 1.0}}}},
+				{"filter", {{"type", "bandpass"}, {"low", 10}, {"high", 1000}}}};
+		}
+
+		return config;
+	}
+}  // namespace
+
+TEST_CASE("jsonHelper merge", "[benchmark][jsonHelper]") {
+	for (const size_t devices : {4, 64}) {
+		const auto base = make_config(devices, "base");
+
+		// site specific overrides of a few values
+		json patch = make_config(devices / 4, "site");
+		for (auto& device : patch["devices"]) {
+			device = {{"limits", {{"alarm", 8.0}}}, {"enabled", false}};
+		}
+
+		BENCHMARK(fmt::format("flatten merge_json, {} devices", devices)) {
+			return flattening_merge_json(base, patch);
+		};
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+		BENCHMARK(fmt::format("merge_json, {} devices", devices)) {
+			return bestsens::merge_json(base, patch);
+		};
+#pragma GCC diagnostic pop
+
+		BENCHMARK(fmt::format("merge_json_inplace, {} devices", devices)) {
+			auto result = base;
+			bestsens::merge_json_inplace(result, patch);
+			return result;
+		};
+
+		BENCHMARK(fmt::format("json::update merge_objects, {} devices", devices)) {
+			auto result = base;
+			result.update(patch, true);
+			return result;
+		};
+
+		BENCHMARK(fmt::format("copy only, {} devices", devices)) {
+			return json(base);
+		};
+	}
+}
+
+TEST_CASE("jsonHelper delta encoding", "[benchmark][jsonHelper]") {
+	json status = json::object();
+	for (size_t i = 0; i < 200; ++i) {
+		status[fmt::format("channel_{}", i)] = {{"rms", 1.0}, {"peak", 2.0}, {"state", "ok"}, {"limits", {{"warning", 4.5}, {"alarm", 7.1}}}};
+	}
+
+	bestsens::json_delta_encoder encoder;
+	encoder.encode(status);
+
+	size_t cycle{0};
+
+	// every cycle changes two of 200 channels
+	const auto update = [&]() {
+		++cycle;
+		status[fmt::format("channel_{}", cycle % 200)]["rms"] = static_cast<double>(cycle);
+		status[fmt::format("channel_{}", (cycle * 7) % 200)]["peak"] = static_cast<double>(cycle);
+	};
+
+	BENCHMARK("full document dump") {
+		update();
+		return status.dump();
+	};
+
+	BENCHMARK("json_delta_encoder + dump") {
+		update();
+		const auto delta = encoder.encode(status);
+		return delta ? delta->dump() : std::string{};
+	};
+
+	fmt::print("full document {} bytes, delta {} bytes\n", status.dump().size(), [&]() {
+		update();
+		const auto delta = encoder.encode(status);
+		return delta ? delta->dump().size() : 0;
+	}());
+}
+
+TEST_CASE("jsonHelper arena documents", "[benchmark][jsonHelper]") {
+	json request = {{"command", "channel_data"}, {"api", 2}};
+	for (size_t i = 0; i < 32; ++i) {
+		request["payload"]["channels"].push_back(
+			{{"name", fmt::format("channel name number {}", i)}, {"rms", 1.5}, {"peak", 4.2}, {"unit", "mm/s"}});
+	}
+
+	const auto text = request.dump();
+
+	BENCHMARK("json parse, update, dump") {
+		auto j = json::parse(text);
+		j["payload"]["timestamp"] = 1234567890;
+		bestsens::arithmetic_add_json_inplace(j["payload"]["channels"][0], j["payload"]["channels"][1]);
+		return j.dump().size();
+	};
+
+	bestsens::json_arena arena;
+
+	BENCHMARK("arena_json parse, update, dump") {
+		size_t size{0};
+
+		{
+			const bestsens::json_arena_scope scope(arena);
+
+			auto j = bestsens::arena_json::parse(text);
+			j["payload"]["timestamp"] = 1234567890;
+			bestsens::arithmetic_add_json_inplace(j["payload"]["channels"][0], j["payload"]["channels"][1]);
+			size = j.dump().size();
+		}
+
+		arena.release();
+		return size;
+	};
+}
+
+TEST_CASE("jsonHelper path lookup", "[benchmark][jsonHelper]") {
+	json message = {{"command", "channel_data"}, {"api", 2}};
+	for (size_t i = 0; i < 8; ++i) {
+		message["payload"]["data"]["channels"].push_back(
+			{{"name", fmt::format("channel_{}", i)}, {"rms", static_cast<double>(i)}, {"peak", 4.2}, {"unit", "mm/s"}});
+	}
+
+	BENCHMARK("is_json_object chain") {
+		if (bestsens::is_json_object(message, "payload") && bestsens::is_json_object(message["payload"], "data") &&
+			bestsens::is_json_array(message["payload"]["data"], "channels") &&
+			message["payload"]["data"]["channels"].size() > 3 &&
+			bestsens::is_json_number(message["payload"]["data"]["channels"][3], "rms")) {
+			return message["payload"]["data"]["channels"][3]["rms"].get<double>();
+		}
+
+		return 0.0;
+	};
+
+	BENCHMARK("json::value with json_pointer") {
+		return message.value("/payload/data/channels/3/rms"_json_pointer, 0.0);
+	};
+
+	const bestsens::json_path rms("/payload/data/channels/3/rms");
+
+	BENCHMARK("json_path::get") {
+		return rms.get<double>(message).value_or(0.0);
+	};
+}
+
+TEST_CASE("jsonHelper allocations", "[benchmark][jsonHelper]") {
+	using allocation_counter::per_op;
+
+	const auto sample = make_tree(4, 8, 1.0);
+	auto tree = make_tree(4, 8, 2.0);
+
+	const auto config = make_device_config(50);
+	const auto base = make_config(16, "base");
+	const auto patch = json{{"devices", {{"device_3", {{"limits", {{"alarm", 8.0}}}}}}}};
+
+	json status = json::object();
+	for (size_t i = 0; i < 2000; ++i) {
+		status[fmt::format("value_{}", i)] = {{"value", static_cast<double>(i)}, {"unit", "mm/s"}};
+	}
+
+	const bestsens::json_key_filter filter(std::vector<std::string>{"value_1", "value_7", "value_42"});
+
+	bestsens::json_accumulator accumulator(sample);
+
+	bestsens::json_binding<device_config> binding;
+	binding.bind("port", &device_config::port, 6450)
+		.bind("interval", &device_config::interval, 1.0)
+		.bind("enabled", &device_config::enabled, true)
+		.bind("name", &device_config::name, std::string{});
+	device_config target;
+
+	int timeout_ms{0};
+	std::string name;
+
+	const auto measure = [](const std::string& operation, auto&& f) {
+		const auto allocations = allocation_counter::per_op(f);
+		fmt::print("{:<40} {:>8.1f} allocations/op\n", operation, allocations);
+		return allocations;
+	};
+
+	// the allocation free paths are checked to stay that way
+	CHECK(measure("arithmetic_add_json_inplace", [&]() { bestsens::arithmetic_add_json_inplace(sample, tree); }) == 0.0);
+	CHECK(measure("arithmetic_div_json_inplace", [&]() { bestsens::arithmetic_div_json_inplace(sample, tree); }) == 0.0);
+	measure("arithmetic_add_json", [&]() { tree = bestsens::arithmetic_add_json(sample, tree); });
+	CHECK(measure("json_accumulator::add", [&]() { accumulator.add(sample); }) == 0.0);
+	CHECK(measure("value_ig_type<int>", [&]() { return bestsens::value_ig_type(config, "timeout_ms", 1000); }) == 0.0);
+	CHECK(measure("checkedUpdateFromJSON<int>", [&]() {
+			  bestsens::checkedUpdateFromJSON(config, "timeout_ms", timeout_ms, 1000);
+		  }) == 0.0);
+	measure("checkedUpdateFromJSON<string>", [&]() {
+		bestsens::checkedUpdateFromJSON(config, "name", name, std::string{});
+	});
+	// only the bitmap of seen members, values are read by reference
+	CHECK(measure("json_binding::apply", [&]() { binding.apply(config, target); }) <= 1.0);
+	const bestsens::json_path path("/devices/device_3/limits/alarm");
+	CHECK(measure("json_path::get<double>", [&]() { return path.get<double>(base); }) == 0.0);
+	measure("get_filtered_values, 3 keys", [&]() { return bestsens::get_filtered_values(status, filter); });
+
+	std::vector<json::json_pointer> pointers;
+	for (size_t i = 0; i < 200; ++i) {
+		pointers.emplace_back(fmt::format("/value_{}/value", i * 10));
+	}
+
+	// the copy of the input is included, compare with "copy only, 2000 values"
+	measure("get_filtered_values&&, 200 pointers", [&]() { return bestsens::get_filtered_values(json(status), pointers); });
+	measure("copy only, 2000 values", [&]() { return json(status); });
+	measure("merge_json_inplace, 16 devices", [&]() {
+		auto result = base;
+		bestsens::merge_json_inplace(result, patch);
+	});
+	measure("copy only, 16 devices", [&]() { return json(base); });
+}
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "bone_helper/netHelper.hpp"
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_all.hpp"
+#include "fmt/format.h"
+#include "mock_server.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+	struct history_result {
+		std::vector<double> values{};
+	};
+}  // namespace
+
+template <>
+struct bestsens::json_field_map<history_result> {
+	static constexpr auto fields = std::make_tuple(bestsens::json_field{"values", &history_result::values});
+};
+
+namespace {
+	auto history_handler(const json& request) -> json {
+		const auto size = request.at("payload").value("size", size_t{0});
+
+		std::vector<double> values(size);
+		for (size_t i = 0; i < size; ++i) {
+			values[i] = std::round(std::sin(static_cast<double>(i) / 100.0) * 1000.0) / 1000.0;
+		}
+
+		return {{"command", request.at("command")}, {"payload", {{"values", values}}}};
+	}
+
+	/*
+	 * runs the command repeatedly and reports throughput and latency percentiles
+	 */
+	auto measure(const std::string& name, bestsens::netHelper& socket, const json& payload, size_t iterations) -> void {
+		using clock = std::chrono::steady_clock;
+
+		std::vector<double> latencies;
+		latencies.reserve(iterations);
+
+		const auto start = clock::now();
+
+		for (size_t i = 0; i < iterations; ++i) {
+			const auto t0 = clock::now();
+			socket.getCommandReturnPayload("history", payload);
+			latencies.push_back(std::chrono::duration<double, std::micro>(clock::now() - t0).count());
+		}
+
+		const auto total = std::chrono::duration<double>(clock::now() - start).count();
+
+		std::sort(latencies.begin(), latencies.end());
+		const auto percentile = [&](double p) {
+			return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * static_cast<double>(latencies.size())))];
+		};
+
+		fmt::print("{:<32} {:>10.0f} cmd/s   p50 {:>9.1f} us   p99 {:>9.1f} us\n", name,
+				   static_cast<double>(iterations) / total, percentile(0.5), percentile(0.99));
+	}
+}  // namespace
+
+TEST_CASE("netHelper throughput", "[benchmark][netHelper]") {
+	for (const auto use_ssl : {false, true}) {
+		for (const auto use_msgpack : {false, true}) {
+			const bestsens::test::mock_server server(history_handler, use_msgpack, use_ssl);
+
+			bestsens::netHelper socket("127.0.0.1", server.port(), use_msgpack, true, use_ssl);
+			socket.connect();
+
+			for (const size_t size : {0, 64, 4096, 65536}) {
+				const auto iterations = std::max<size_t>(20, 200000 / std::max<size_t>(size, 100));
+
+				measure(fmt::format("{} {} {} values", use_ssl ? "ssl" : "tcp", use_msgpack ? "msgpack" : "json", size),
+						socket, {{"size", size}}, iterations);
+			}
+		}
+	}
+}
+
+TEST_CASE("netHelper compression latency", "[benchmark][netHelper]") {
+	const bestsens::test::mock_server server(history_handler);
+
+	bestsens::netHelper plain("127.0.0.1", server.port());
+	plain.connect();
+
+	bestsens::netHelper compressed("127.0.0.1", server.port());
+	compressed.connect();
+	REQUIRE(compressed.enable_compression(1024));
+
+	for (const size_t size : {16, 1024, 16 * 1024, 256 * 1024}) {
+		const json payload = {{"size", size}};
+
+		BENCHMARK(fmt::format("uncompressed, {} values", size)) {
+			return plain.getCommandReturnPayload("history", payload);
+		};
+
+		BENCHMARK(fmt::format("zstd, {} values", size)) {
+			return compressed.getCommandReturnPayload("history", payload);
+		};
+	}
+}
+
+TEST_CASE("netHelper per-command overhead", "[benchmark][netHelper]") {
+	const auto use_ssl = GENERATE(false, true);
+
+	const bestsens::test::mock_server server(history_handler, false, use_ssl);
+
+	bestsens::netHelper socket("127.0.0.1", server.port(), false, true, use_ssl);
+	socket.connect();
+
+	const json payload = {{"size", 0}};
+
+	BENCHMARK(fmt::format("{} empty command", use_ssl ? "ssl" : "tcp")) {
+		return socket.getCommandReturnPayload("history", payload);
+	};
+}
+
+TEST_CASE("netHelper prepared commands", "[benchmark][netHelper]") {
+	const auto use_msgpack = GENERATE(false, true);
+
+	const bestsens::test::mock_server server(history_handler, use_msgpack);
+
+	bestsens::netHelper socket("127.0.0.1", server.port(), use_msgpack, true);
+	socket.connect();
+
+	const json payload = {{"size", 0}, {"channels", {"temperature", "speed", "vibration"}}};
+	const auto prepared = socket.prepare("history", payload);
+
+	const auto format = use_msgpack ? "msgpack" : "json";
+
+	BENCHMARK(fmt::format("{} ad-hoc encoding", format)) {
+		return socket.getCommandReturnPayload("history", payload);
+	};
+
+	BENCHMARK(fmt::format("{} prepared command", format)) {
+		return socket.getCommandReturnPayload(prepared);
+	};
+}
+
+TEST_CASE("netHelper typed payload decoding", "[benchmark][netHelper]") {
+	const bestsens::test::mock_server server(history_handler);
+
+	bestsens::netHelper socket("127.0.0.1", server.port(), false, true);
+	socket.connect();
+
+	for (const size_t size : {16, 4096}) {
+		const json payload = {{"size", size}};
+
+		BENCHMARK(fmt::format("DOM, {} values", size)) {
+			return socket.getCommandReturnPayload("history", payload)["values"].get<std::vector<double>>();
+		};
+
+		BENCHMARK(fmt::format("struct_sax, {} values", size)) {
+			return socket.getCommandReturnPayload<history_result>("history", payload).values;
+		};
+	}
+}
@@ -0,0 +1,393 @@
+/*
+ * mock_server.hpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#ifndef MOCK_SERVER_HPP_
+#define MOCK_SERVER_HPP_
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/asio.hpp"
+#include "boost/asio/ssl.hpp"
+#include "fmt/format.h"
+#include "nlohmann/json.hpp"
+
+#ifdef ENABLE_ZSTD_COMPRESSION
+#include <zstd.h>
+#endif
+
+namespace bestsens::test {
+	/*
+	 * Loopback server speaking the netHelper framing: requests are terminated by "\r\n" (or sent
+	 * as length-prefixed zstd frame once compression was negotiated), responses are prefixed
+	 * by their length as 8 hex digits.
+	 *
+	 * The handler returns the response envelope. If it returns an array instead, every element
+	 * is sent as separate frame, binary values as raw frames; this allows to emulate pushed
+	 * frames and binary attachments.
+	 */
+	class mock_server {
+	public:
+		using handler_t = std::function<nlohmann::json(const nlohmann::json& request)>;
+
+		/*
+		 * listens on a random port on 127.0.0.1, or on the unix domain socket `unix_path` if given
+		 */
+		explicit mock_server(handler_t handler, bool use_msgpack = false, bool use_ssl = false,
+							 std::string unix_path = {})
+			: handler(std::move(handler)), use_msgpack(use_msgpack), unix_path(std::move(unix_path)) {
+			using boost::asio::ip::tcp;
+
+			if (use_ssl) {
+				this->ssl_ctx.emplace(boost::asio::ssl::context::tls_server);
+				add_self_signed_certificate(*this->ssl_ctx);
+			}
+
+			if (this->unix_path.empty()) {
+				const tcp::endpoint endpoint(boost::asio::ip::make_address("127.0.0.1"), 0);
+
+				this->acceptor.open(endpoint.protocol());
+				this->acceptor.set_option(tcp::acceptor::reuse_address(true));
+				this->acceptor.bind(endpoint);
+
+				tcp::acceptor::endpoint_type local;
+				std::memcpy(local.data(), this->acceptor.local_endpoint().data(), local.size());
+				this->listen_port = std::to_string(local.port());
+			} else {
+				const boost::asio::local::stream_protocol::endpoint endpoint(this->unix_path);
+
+				::unlink(this->unix_path.c_str());
+				this->acceptor.open(endpoint.protocol());
+				this->acceptor.bind(endpoint);
+			}
+
+			this->acceptor.listen();
+
+			this->accept_thread = std::thread([this]() { this->accept_loop(); });
+		}
+
+		~mock_server() {
+			this->stopping = true;
+
+			// wake up the blocking accept
+			try {
+				socket_t s(this->io_context);
+				s.connect(this->acceptor.local_endpoint());
+			} catch (...) {}
+
+			this->accept_thread.join();
+
+			{
+				const std::lock_guard<std::mutex> lock(this->connection_mtx);
+				for (auto& c : this->connections) {
+					::shutdown(c.socket.native_handle(), SHUT_RDWR);
+				}
+			}
+
+			for (auto& c : this->connections) {
+				c.thread.join();
+			}
+
+			if (!this->unix_path.empty()) {
+				::unlink(this->unix_path.c_str());
+			}
+		}
+
+		mock_server(const mock_server&) = delete;
+		mock_server(mock_server&&) = delete;
+		auto operator=(const mock_server&) -> mock_server& = delete;
+		auto operator=(mock_server&&) -> mock_server& = delete;
+
+		auto port() const -> std::string {
+			return this->listen_port;
+		}
+
+		auto connection_count() -> size_t {
+			const std::lock_guard<std::mutex> lock(this->connection_mtx);
+			return this->connections.size();
+		}
+
+		/*
+		 * lets "set_compression" fail like on servers without compression support
+		 */
+		auto set_compression_support(bool supported) -> void {
+			this->compression_supported = supported;
+		}
+
+		/*
+		 * number of requests received as zstd frame
+		 */
+		auto compressed_requests() const -> size_t {
+			return this->compressed_count;
+		}
+
+	private:
+		// generic sockets serve tcp and unix domain connections alike
+		using socket_t = boost::asio::generic::stream_protocol::socket;
+
+		struct connection {
+			socket_t socket;
+			std::thread thread{};
+		};
+
+		handler_t handler;
+		bool use_msgpack;
+		std::string unix_path;
+		std::string listen_port{};
+
+		std::atomic<bool> stopping{false};
+		std::atomic<bool> compression_supported{true};
+		std::atomic<size_t> compressed_count{0};
+
+		boost::asio::io_context io_context{};
+		boost::asio::basic_socket_acceptor<boost::asio::generic::stream_protocol> acceptor{io_context};
+		std::optional<boost::asio::ssl::context> ssl_ctx{};
+		std::thread accept_thread{};
+
+		std::mutex connection_mtx{};
+		std::list<connection> connections{};
+
+		static auto add_self_signed_certificate(boost::asio::ssl::context& ctx) -> void {
+			const std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> pctx(
+				EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr), EVP_PKEY_CTX_free);
+
+			EVP_PKEY* raw_key = nullptr;
+
+			if (EVP_PKEY_keygen_init(pctx.get()) <= 0 ||
+				EVP_PKEY_CTX_set_ec_paramgen_curve_nid(pctx.get(), NID_X9_62_prime256v1) <= 0 ||
+				EVP_PKEY_keygen(pctx.get(), &raw_key) <= 0) {
+				throw std::runtime_error("could not generate key");
+			}
+
+			const std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key(raw_key, EVP_PKEY_free);
+			const std::unique_ptr<X509, decltype(&X509_free)> cert(X509_new(), X509_free);
+
+			X509_set_version(cert.get(), 2);
+			ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), 1);
+			X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+			X509_gmtime_adj(X509_getm_notAfter(cert.get()), 24L * 60 * 60);
+			X509_set_pubkey(cert.get(), key.get());
+
+			auto* name = X509_get_subject_name(cert.get());
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"),
+									   -1, -1, 0);
+			X509_set_issuer_name(cert.get(), name);
+
+			if (X509_sign(cert.get(), key.get(), EVP_sha256()) == 0) {
+				throw std::runtime_error("could not sign certificate");
+			}
+
+			const auto to_pem = [](auto write) {
+				const std::unique_ptr<BIO, decltype(&BIO_free)> bio(BIO_new(BIO_s_mem()), BIO_free);
+				write(bio.get());
+
+				char* data = nullptr;
+				const auto len = BIO_get_mem_data(bio.get(), &data);
+				return std::string(data, static_cast<size_t>(len));
+			};
+
+			const auto cert_pem = to_pem([&](BIO* bio) { PEM_write_bio_X509(bio, cert.get()); });
+			const auto key_pem = to_pem(
+				[&](BIO* bio) { PEM_write_bio_PrivateKey(bio, key.get(), nullptr, nullptr, 0, nullptr, nullptr); });
+
+			ctx.use_certificate(boost::asio::buffer(cert_pem), boost::asio::ssl::context::pem);
+			ctx.use_private_key(boost::asio::buffer(key_pem), boost::asio::ssl::context::pem);
+		}
+
+		auto accept_loop() -> void {
+			while (!this->stopping) {
+				socket_t s(this->io_context);
+
+				boost::system::error_code ec;
+				this->acceptor.accept(s, ec);
+
+				if (ec || this->stopping) {
+					continue;
+				}
+
+				if (this->unix_path.empty()) {
+					s.set_option(boost::asio::ip::tcp::no_delay(true));
+				}
+
+				const std::lock_guard<std::mutex> lock(this->connection_mtx);
+				auto& c = this->connections.emplace_back(connection{std::move(s)});
+
+				c.thread = std::thread([this, &c]() {
+					if (!this->ssl_ctx) {
+						this->serve(c.socket);
+						return;
+					}
+
+					boost::asio::ssl::stream<socket_t&> stream(c.socket, *this->ssl_ctx);
+
+					boost::system::error_code ec;
+					stream.handshake(boost::asio::ssl::stream_base::server, ec);
+
+					if (!ec) {
+						this->serve(stream);
+					}
+				});
+			}
+		}
+
+		template <typename Stream>
+		auto serve(Stream& s) -> void {
+			std::vector<uint8_t> buffer;
+			std::array<uint8_t, 64 * 1024> chunk{};
+
+			[[maybe_unused]] size_t compression_threshold = 0;
+			bool compression = false;
+
+			while (true) {
+				nlohmann::json request;
+
+				while (!this->extract_request(buffer, request)) {
+					boost::system::error_code ec;
+					const auto t = s.read_some(boost::asio::buffer(chunk), ec);
+
+					if (ec) {
+						return;
+					}
+
+					buffer.insert(buffer.end(), chunk.begin(), chunk.begin() + static_cast<long>(t));
+				}
+
+				nlohmann::json response;
+
+				if (request.value("command", "") == "set_compression") {
+#ifdef ENABLE_ZSTD_COMPRESSION
+					compression = this->compression_supported;
+#endif
+
+					if (compression) {
+						compression_threshold = request.at("payload").value("threshold", size_t{0});
+						response = {{"command", "set_compression"}, {"payload", {{"compression", "zstd"}}}};
+					} else {
+						response = {{"command", "set_compression"}, {"payload", {{"error", "not supported"}}}};
+					}
+				} else {
+					response = this->handler(request);
+				}
+
+				const auto frames = response.is_array() ? response : nlohmann::json::array({response});
+
+				for (const auto& frame : frames) {
+					auto body = [&]() -> std::vector<uint8_t> {
+						if (frame.is_binary()) {
+							return frame.get_binary();
+						}
+
+						if (this->use_msgpack) {
+							return nlohmann::json::to_msgpack(frame);
+						}
+
+						const auto str = frame.dump();
+						return {str.begin(), str.end()};
+					}();
+
+					if (compression && !frame.is_binary() && body.size() >= compression_threshold) {
+						body = compress(body);
+					}
+
+					const auto header = fmt::format("{:08x}", body.size());
+					body.insert(body.begin(), header.begin(), header.end());
+
+					boost::system::error_code ec;
+					boost::asio::write(s, boost::asio::buffer(body), ec);
+
+					if (ec) {
+						return;
+					}
+				}
+			}
+		}
+
+		auto extract_request(std::vector<uint8_t>& buffer, nlohmann::json& request) -> bool {
+			// length-prefixed compressed request
+			if (buffer.size() >= 8 && std::all_of(buffer.begin(), buffer.begin() + 8, ::isxdigit)) {
+				const std::string len_str(buffer.begin(), buffer.begin() + 8);
+				const auto len = std::strtoul(len_str.c_str(), nullptr, 16);
+
+				if (buffer.size() < 8 + len) {
+					return false;
+				}
+
+				const auto data = decompress({buffer.begin() + 8, buffer.begin() + 8 + static_cast<long>(len)});
+				buffer.erase(buffer.begin(), buffer.begin() + 8 + static_cast<long>(len));
+				++this->compressed_count;
+
+				request = this->use_msgpack ? nlohmann::json::from_msgpack(data) : nlohmann::json::parse(data);
+				return true;
+			}
+
+			// "\r\n" may also be part of a msgpack request, try every candidate
+			const std::array<uint8_t, 2> delimiter{'\r', '\n'};
+
+			for (auto it = std::search(buffer.begin(), buffer.end(), delimiter.begin(), delimiter.end());
+				 it != buffer.end(); it = std::search(it + 1, buffer.end(), delimiter.begin(), delimiter.end())) {
+				try {
+					request = this->use_msgpack ? nlohmann::json::from_msgpack(buffer.begin(), it)
+												: nlohmann::json::parse(buffer.begin(), it);
+				} catch (const nlohmann::json::parse_error&) {
+					if (!this->use_msgpack) {
+						throw;
+					}
+
+					continue;
+				}
+
+				buffer.erase(buffer.begin(), it + 2);
+				return true;
+			}
+
+			return false;
+		}
+
+		static auto compress(const std::vector<uint8_t>& data) -> std::vector<uint8_t> {
+#ifdef ENABLE_ZSTD_COMPRESSION
+			std::vector<uint8_t> result(ZSTD_compressBound(data.size()));
+			result.resize(ZSTD_compress(result.data(), result.size(), data.data(), data.size(), 1));
+			return result;
+#else
+			return data;
+#endif
+		}
+
+		static auto decompress(const std::vector<uint8_t>& data) -> std::vector<uint8_t> {
+#ifdef ENABLE_ZSTD_COMPRESSION
+			std::vector<uint8_t> result(ZSTD_getFrameContentSize(data.data(), data.size()));
+			result.resize(ZSTD_decompress(result.data(), result.size(), data.data(), data.size()));
+			return result;
+#else
+			return data;
+#endif
+		}
+	};
+}  // namespace bestsens::test
+
+#endif /* MOCK_SERVER_HPP_ */
@@ -1,6 +1,8 @@
 #include <iostream>
+#include <memory_resource>
 #include <vector>
 
+#include "bone_helper/jsonArena.hpp"
 #include "bone_helper/jsonHelper.hpp"
 #include "catch2/catch_all.hpp"
 
@@ -57,4 +59,639 @@ TEST_CASE("json filter should also work with more complex types") {
 	CHECK(filtered_input["test"]["object2"] == 24);
 	CHECK(filtered_input["test2"] == nullptr);
 	CHECK(filtered_input["test3"] == nullptr);
-}
\ No newline at end of file
+}
+
+TEST_CASE("json filter should accept prebuilt key sets and braced lists") {
+	const json input = {{"test", 23}, {"test2", 42}, {"test3", 5}};
+
+	const auto braced = get_filtered_values(input, {"test", "test2"});
+	CHECK(braced == json{{"test", 23}, {"test2", 42}});
+
+	const json_key_filter small(std::vector<std::string>{"test3", "missing"});
+	CHECK(get_filtered_values(input, small) == json{{"test3", 5}});
+
+	const json_key_filter large(std::vector<std::string>{"test", "test2", "a", "b", "c"});
+	CHECK(get_filtered_values(input, large) == braced);
+
+	CHECK(get_filtered_values(input, json_key_filter(std::vector<std::string>{"missing"})).is_null());
+}
+
+TEST_CASE("json filter should move values out of rvalues") {
+	json input = {{"test", {1, 2, 3}}, {"test2", "text"}, {"test3", 5}};
+
+	const auto filtered = get_filtered_values(std::move(input), std::vector<std::string>{"test", "test2", "test"});
+
+	CHECK(filtered == json{{"test", {1, 2, 3}}, {"test2", "text"}});
+}
+
+TEST_CASE("json filter should keep nested json pointer paths") {
+	const json input = {
+		{"payload", {{"speed", 1500}, {"temperature", 41.5}, {"channels", {{{"rms", 1.0}}, {{"rms", 2.0}}}}}},
+		{"command", "status"}
+	};
+
+	const std::vector<json::json_pointer> filter{"/payload/speed"_json_pointer, "/payload/channels/1/rms"_json_pointer,
+												 "/payload/missing"_json_pointer};
+
+	const auto filtered = get_filtered_values(input, filter);
+
+	CHECK(filtered["payload"]["speed"] == 1500);
+	CHECK_FALSE(filtered["payload"].contains("temperature"));
+	CHECK_FALSE(filtered["payload"].contains("missing"));
+	CHECK(filtered["payload"]["channels"] == json{nullptr, {{"rms", 2.0}}});
+	CHECK_FALSE(filtered.contains("command"));
+
+	CHECK(get_filtered_values(json(input), filter) == filtered);
+	CHECK(get_filtered_values(input, std::vector<json::json_pointer>{}) == input);
+}
+
+TEST_CASE("json filter should handle duplicate and overlapping pointers on rvalues") {
+	const json input = {{"a", {{"b", 1}, {"c", 2}}}, {"d", 3}};
+
+	for (const auto& filter : {std::vector<json::json_pointer>{"/a"_json_pointer, "/a"_json_pointer},
+							   std::vector<json::json_pointer>{"/a/b"_json_pointer, "/a"_json_pointer},
+							   std::vector<json::json_pointer>{"/a"_json_pointer, "/a/b"_json_pointer, "/d"_json_pointer},
+							   std::vector<json::json_pointer>{""_json_pointer, "/d"_json_pointer}}) {
+		const auto expected = get_filtered_values(input, filter);
+
+		CHECK(expected["a"] == input["a"]);
+		CHECK(get_filtered_values(json(input), filter) == expected);
+	}
+
+	// a shared prefix of the key name is not an overlap
+	const json names = {{"a", 1}, {"ab", 2}};
+	CHECK(get_filtered_values(json(names), std::vector<json::json_pointer>{"/a"_json_pointer, "/ab"_json_pointer}) == names);
+
+	// children that are not next to their parent in byte order
+	const json nested = {{"a", {{"b", 1}, {"c", 2}}}, {"a!", 3}};
+
+	for (const auto& filter : {std::vector<json::json_pointer>{"/a/c"_json_pointer, "/a!"_json_pointer, "/a"_json_pointer},
+							   std::vector<json::json_pointer>{"/a/b"_json_pointer, "/a/c"_json_pointer, "/a"_json_pointer}}) {
+		CHECK(get_filtered_values(json(nested), filter) == get_filtered_values(nested, filter));
+	}
+}
+
+TEST_CASE("merge_json_inplace should patch like the flattening merge_json") {
+	json target = {
+		{"name", "sensor"},
+		{"limits", {{"warning", 4.5}, {"alarm", 7.1}}},
+		{"channels", {1, 2, 3}},
+		{"empty", json::object()}
+	};
+
+	SECTION("leaves are replaced and subtrees merged") {
+		CHECK(merge_json_inplace(target, {{"limits", {{"alarm", 8.0}, {"trip", 10.0}}}, {"channels", {5}}, {"new", true}}));
+
+		CHECK(target["name"] == "sensor");
+		CHECK(target["limits"] == json{{"warning", 4.5}, {"alarm", 8.0}, {"trip", 10.0}});
+		CHECK(target["channels"] == json{5, 2, 3});
+		CHECK(target["new"] == true);
+		CHECK(target["empty"].is_null());
+	}
+
+	SECTION("longer arrays are extended") {
+		CHECK(merge_json_inplace(target, {{"channels", {1, 2, 3, 4}}}));
+		CHECK(target["channels"] == json{1, 2, 3, 4});
+	}
+
+	SECTION("null and empty values do not remove subtrees") {
+		CHECK(merge_json_inplace(target, {{"limits", nullptr}, {"channels", json::array()}, {"name", json::object()}}));
+
+		CHECK(target["limits"]["alarm"] == 7.1);
+		CHECK(target["channels"] == json{1, 2, 3});
+		CHECK(target["name"].is_null());
+	}
+
+	SECTION("conflicts leave the target untouched") {
+		const auto original = target;
+
+		CHECK_FALSE(merge_json_inplace(target, {{"limits", 5}}));
+		CHECK(target == original);
+
+		CHECK_FALSE(merge_json_inplace(target, {{"name", {{"first", "a"}}}}));
+		CHECK(target == original);
+	}
+
+	SECTION("primitive targets are replaced on conflict") {
+		json primitive = 5;
+
+		CHECK_FALSE(merge_json_inplace(primitive, {{"a", 1}}));
+		CHECK(primitive == json{{"a", 1}});
+	}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+	SECTION("merge_json is built on it") {
+		const auto merged = merge_json(target, {{"limits", {{"alarm", 8.0}}}});
+
+		CHECK(merged["limits"]["alarm"] == 8.0);
+		CHECK(merged["empty"].is_null());
+		CHECK(merge_json(target, {{"limits", 5}}) == target);
+	}
+#pragma GCC diagnostic pop
+}
+
+TEST_CASE("arithmetic merge should combine numbers in place") {
+	json to = {
+		{"int", 4},
+		{"double", 1.5},
+		{"string", "unchanged"},
+		{"nested", {{"value", 10}, {"array", {1, 2, 3}}}},
+		{"mismatch", {1, 2}}
+	};
+
+	const json from = {
+		{"int", 2},
+		{"double", 0.5},
+		{"string", "ignored"},
+		{"nested", {{"value", 5}, {"array", {1, 1}}}},
+		{"mismatch", {{"key", 1}}}
+	};
+
+	SECTION("add") {
+		arithmetic_add_json_inplace(from, to);
+
+		CHECK(to["int"] == 6);
+		CHECK(to["int"].is_number_integer());
+		CHECK(to["double"] == 2.0);
+		CHECK(to["string"] == "unchanged");
+		CHECK(to["nested"]["value"] == 15);
+		CHECK(to["nested"]["array"] == json{2, 3, 3});
+		CHECK(to["mismatch"] == json{1, 2});
+	}
+
+	SECTION("sub") {
+		arithmetic_sub_json_inplace(from, to);
+
+		CHECK(to["int"] == -2);
+		CHECK(to["double"] == -1.0);
+	}
+
+	SECTION("mul") {
+		arithmetic_mul_json_inplace(from, to);
+
+		CHECK(to["int"] == 8);
+		CHECK(to["double"] == 0.75);
+	}
+
+	SECTION("div") {
+		arithmetic_div_json_inplace(json{{"int", 8}, {"double", 3.0}, {"nested", {{"value", 0}}}}, to);
+
+		CHECK(to["int"] == 2.0);
+		CHECK(to["double"] == 2.0);
+		CHECK(to["nested"]["value"] == 0.0);
+	}
+
+	SECTION("value versions leave their input untouched") {
+		const auto original = to;
+		const auto result = arithmetic_add_json(from, to);
+
+		CHECK(to == original);
+
+		arithmetic_add_json_inplace(from, to);
+		CHECK(result == to);
+	}
+
+	SECTION("keys missing in the target throw") {
+		CHECK_THROWS_AS(arithmetic_add_json_inplace(json{{"missing", 1}}, to), json::out_of_range);
+	}
+}
+
+TEST_CASE("arithmetic merge should handle numeric arrays") {
+	SECTION("float arrays") {
+		json to = {{"spectrum", {1.0, 2.0, 3.0, 4.0}}};
+		arithmetic_add_json_inplace(json{{"spectrum", {0.5, 0.5, 0.5}}}, to);
+
+		CHECK(to["spectrum"] == json{1.5, 2.5, 3.5, 4.0});
+		CHECK(to["spectrum"][0].is_number_float());
+
+		arithmetic_div_json_inplace(json{{"spectrum", {3.0, 5.0, 7.0, 2.0}}}, to);
+		CHECK(to["spectrum"] == json{2.0, 2.0, 2.0, 0.5});
+	}
+
+	SECTION("integer arrays stay integer, except for div") {
+		json to = {1, 2, 3};
+		arithmetic_mul_json_inplace(json{2, 3, 4}, to);
+
+		CHECK(to == json{2, 6, 12});
+		CHECK(to[0].is_number_integer());
+
+		arithmetic_div_json_inplace(json{4, 3, 24}, to);
+		CHECK(to == json{2.0, 0.5, 2.0});
+		CHECK(to[0].is_number_float());
+	}
+
+	SECTION("mixed arrays are merged element by element") {
+		json to = {1, 2.5, "text", {{"key", 1}}, 3u};
+		arithmetic_add_json_inplace(json{1.5, 1, 2, {{"key", 2}}, 1}, to);
+
+		CHECK(to == json{2.5, 3.5, "text", {{"key", 3}}, 4});
+		CHECK(to[4].is_number_integer());
+	}
+}
+
+TEST_CASE("json_accumulator should sum documents of the same shape") {
+	const json shape = {
+		{"count", 0},
+		{"temperature", 0.0},
+		{"name", "sensor"},
+		{"channels", {{{"rms", 0.0}, {"peak", 0}}, {{"rms", 0.0}, {"peak", 0}}}}
+	};
+
+	json_accumulator accumulator(shape);
+	CHECK(accumulator.leaf_count() == 6);
+
+	accumulator.add({{"count", 1}, {"temperature", 20.0}, {"name", "other"},
+					 {"channels", {{{"rms", 1.0}, {"peak", 2}}, {{"rms", 3.0}, {"peak", 4}}}}});
+	accumulator.add({{"count", 3}, {"temperature", 22.0}, {"extra", 1}, {"channels", {{{"rms", 2.0}, {"peak", 4}}}}});
+
+	CHECK(accumulator.count() == 2);
+
+	SECTION("sum keeps integer leaves integer") {
+		const auto sum = accumulator.sum();
+
+		CHECK(sum["count"] == 4);
+		CHECK(sum["count"].is_number_integer());
+		CHECK(sum["temperature"] == 42.0);
+		CHECK(sum["name"] == "sensor");
+		CHECK(sum["channels"][0]["rms"] == 3.0);
+		CHECK(sum["channels"][0]["peak"] == 6);
+		CHECK(sum["channels"][1]["rms"] == 3.0);
+		CHECK(sum["channels"][1]["peak"] == 4);
+		CHECK_FALSE(sum.contains("extra"));
+	}
+
+	SECTION("mean converts all leaves to float") {
+		const auto mean = accumulator.mean();
+
+		CHECK(mean["count"] == 2.0);
+		CHECK(mean["count"].is_number_float());
+		CHECK(mean["temperature"] == 21.0);
+		CHECK(mean["channels"][0]["peak"] == 3.0);
+		CHECK(mean["channels"][1]["rms"] == 1.5);
+	}
+
+	SECTION("path index") {
+		CHECK(accumulator.sum_of("/channels/0/peak"_json_pointer) == 6.0);
+		CHECK(accumulator.sum_of("/temperature"_json_pointer) == 42.0);
+		CHECK_FALSE(accumulator.sum_of("/name"_json_pointer).has_value());
+		CHECK_FALSE(accumulator.sum_of("/channels"_json_pointer).has_value());
+	}
+
+	SECTION("accumulators of the same shape can be combined") {
+		json_accumulator other(shape);
+		other.add(accumulator.sum());
+
+		accumulator.add(other);
+		CHECK(accumulator.count() == 3);
+		CHECK(accumulator.sum()["count"] == 8);
+
+		CHECK_THROWS_AS(accumulator.add(json_accumulator(json{{"count", 0}})), std::invalid_argument);
+	}
+
+	SECTION("float samples turn integer leaves into floats") {
+		accumulator.add(json{{"count", 0.5}});
+
+		const auto sum = accumulator.sum();
+		CHECK(sum["count"] == 4.5);
+		CHECK(sum["count"].is_number_float());
+		CHECK(sum["channels"][0]["peak"].is_number_integer());
+		CHECK(accumulator.sum_of("/count"_json_pointer) == 4.5);
+		CHECK(accumulator.mean()["count"] == 1.5);
+
+		json_accumulator other(shape);
+		other.add(accumulator);
+		CHECK(other.sum()["count"] == 4.5);
+
+		accumulator.reset();
+		CHECK(accumulator.sum()["count"].is_number_integer());
+	}
+
+	SECTION("reset") {
+		accumulator.reset();
+
+		CHECK(accumulator.count() == 0);
+		CHECK(accumulator.sum()["temperature"] == 0.0);
+	}
+}
+
+namespace {
+	struct binding_config {
+		int port{0};
+		double interval{1.0};
+		bool enabled{false};
+		std::string name{"default"};
+		std::vector<int> channels{};
+	};
+}  // namespace
+
+TEST_CASE("json_binding should update bound members in one pass") {
+	json_binding<binding_config> binding;
+	binding.bind("port", &binding_config::port, 6450)
+		.bind("interval", &binding_config::interval)
+		.bind("enabled", &binding_config::enabled, true)
+		.bind("name", &binding_config::name, std::string{"unnamed"})
+		.bind("channels", &binding_config::channels);
+
+	CHECK(binding.size() == 5);
+	CHECK_THROWS_AS(binding.bind("port", &binding_config::port), std::invalid_argument);
+
+	binding_config config;
+
+	SECTION("present keys are applied, missing keys fall back to their default") {
+		const auto changed = binding.apply({{"port", 80}, {"channels", {1, 2}}, {"unknown", 1}}, config);
+
+		CHECK(changed == 4);
+		CHECK(config.port == 80);
+		CHECK(config.interval == 1.0);
+		CHECK(config.enabled);
+		CHECK(config.name == "unnamed");
+		CHECK(config.channels == std::vector<int>{1, 2});
+	}
+
+	SECTION("wrong types are treated like missing keys") {
+		config.interval = 2.0;
+		binding.apply({{"port", "80"}, {"interval", "fast"}, {"enabled", 1}, {"name", 5}}, config);
+
+		CHECK(config.port == 6450);
+		CHECK(config.interval == 2.0);
+		CHECK(config.enabled);
+		CHECK(config.name == "unnamed");
+	}
+
+	SECTION("unchanged members are not counted") {
+		const json j = {{"port", 81}, {"interval", 0.5}, {"enabled", false}, {"name", "sensor"}};
+
+		CHECK(binding.apply(j, config) == 3);	// enabled already is false
+		CHECK(binding.apply(j, config) == 0);
+
+		CHECK(config.port == 81);
+		CHECK(config.interval == 0.5);
+		CHECK_FALSE(config.enabled);
+		CHECK(config.name == "sensor");
+	}
+
+	SECTION("objects with mostly unbound members") {
+		json j = {{"port", 82}, {"name", "sensor"}};
+		for (int i = 0; i < 20; ++i) {
+			j["other_" + std::to_string(i)] = i;
+		}
+
+		CHECK(binding.apply(j, config) == 3);
+		CHECK(config.port == 82);
+		CHECK(config.name == "sensor");
+		CHECK(config.enabled);
+	}
+
+	SECTION("non-objects only apply defaults") {
+		CHECK(binding.apply(json::array(), config) == 3);
+		CHECK(config.port == 6450);
+	}
+}
+
+TEST_CASE("json_delta_encoder should only emit changes") {
+	json_delta_encoder encoder;
+	json received;
+
+	json status = {
+		{"speed", 1500},
+		{"temperature", 41.5},
+		{"state", {{"running", true}, {"alarms", json::array()}}},
+		{"spectrum", {1, 2, 3}}
+	};
+
+	auto delta = encoder.encode(status);
+	REQUIRE(delta);
+	CHECK(*delta == status);
+	apply_json_delta(received, *delta);
+	CHECK(received == status);
+
+	SECTION("unchanged documents give no patch") {
+		CHECK_FALSE(encoder.encode(status));
+	}
+
+	SECTION("changed, added and removed members") {
+		status["speed"] = 1510;
+		status["state"]["alarms"].push_back("overheat");
+		status["spectrum"][1] = 5;
+		status["load"] = 0.8;
+		status.erase("temperature");
+
+		delta = encoder.encode(status);
+		REQUIRE(delta);
+		CHECK(*delta == json{{"speed", 1510},
+							 {"state", {{"alarms", {"overheat"}}}},
+							 {"spectrum", {1, 5, 3}},
+							 {"load", 0.8},
+							 {"temperature", nullptr}});
+
+		apply_json_delta(received, *delta);
+		CHECK(received == status);
+		CHECK_FALSE(encoder.encode(status));
+	}
+
+	SECTION("null members are treated as absent") {
+		status["state"] = nullptr;
+
+		delta = encoder.encode(status);
+		REQUIRE(delta);
+		CHECK(*delta == json{{"state", nullptr}});
+
+		apply_json_delta(received, *delta);
+		CHECK_FALSE(received.contains("state"));
+		CHECK_FALSE(encoder.encode(status));
+	}
+
+	SECTION("unchanged documents with nested null members give no patch") {
+		const json document = {{"status", {{"error", nullptr}, {"speed", 5}}}, {"x", 1}};
+
+		json_delta_encoder nested;
+		REQUIRE(nested.encode(document));
+		CHECK_FALSE(nested.encode(document));
+		CHECK_FALSE(nested.encode(document));
+
+		auto changed = document;
+		changed["status"]["speed"] = 6;
+
+		delta = nested.encode(changed);
+		REQUIRE(delta);
+		CHECK(*delta == json{{"status", {{"speed", 6}}}});
+		CHECK_FALSE(nested.encode(changed));
+	}
+
+	SECTION("type changes replace the member") {
+		status["state"] = "stopped";
+
+		delta = encoder.encode(status);
+		REQUIRE(delta);
+		CHECK(*delta == json{{"state", "stopped"}});
+	}
+
+	SECTION("reset sends the full document again") {
+		encoder.reset();
+		CHECK(encoder.encode(status) == status);
+	}
+
+	SECTION("non-object documents are replaced") {
+		const std::vector<json> documents = {json{1, 2}, json{1, 2}, json{1, 2}, json{1, 3}, 5,   5,
+											 status,     status,     json{1, 2}, nullptr,    status};
+
+		for (const auto& document : documents) {
+			if (const auto d = encoder.encode(document)) {
+				apply_json_delta(received, *d);
+			}
+
+			CHECK(received == document);
+		}
+	}
+}
+
+namespace {
+	/*
+	 * forwards to new/delete and counts the outstanding allocations
+	 */
+	class counting_resource : public std::pmr::memory_resource {
+	public:
+		size_t allocations{0};
+		size_t outstanding{0};
+
+	private:
+		auto do_allocate(size_t bytes, size_t alignment) -> void* override {
+			++this->allocations;
+			++this->outstanding;
+			return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+		}
+
+		auto do_deallocate(void* p, size_t bytes, size_t alignment) -> void override {
+			--this->outstanding;
+			std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+		}
+
+		auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override {
+			return this == &other;
+		}
+	};
+}  // namespace
+
+TEST_CASE("arena_json should allocate from the current scope") {
+	counting_resource resource;
+
+	SECTION("documents are allocated from the scope and freed to it") {
+		{
+			const json_arena_scope scope(&resource);
+
+			auto j = arena_json::parse(R"({"name": "a string longer than the small string buffer", "values": [1, 2, 3]})");
+			CHECK(j["values"].size() == 3);
+			CHECK(resource.allocations > 0);
+		}
+
+		CHECK(resource.outstanding == 0);
+	}
+
+	SECTION("blocks freed outside of their scope go back to their resource") {
+		arena_json j;
+
+		{
+			const json_arena_scope scope(&resource);
+			j = arena_json::parse(R"({"values": [1, 2, 3]})");
+		}
+
+		const auto allocations = resource.allocations;
+		j["values"].push_back(4);	// outside of the scope, taken from the default resource
+		CHECK(resource.allocations == allocations);
+
+		j = nullptr;
+		CHECK(resource.outstanding == 0);
+	}
+
+	SECTION("nested scopes restore the previous resource") {
+		counting_resource inner;
+		const json_arena_scope outer_scope(&resource);
+
+		{
+			const json_arena_scope inner_scope(&inner);
+			CHECK(json_arena_scope::current() == &inner);
+		}
+
+		CHECK(json_arena_scope::current() == &resource);
+	}
+}
+
+TEST_CASE("jsonHelper functions should accept arena_json") {
+	json_arena arena;
+	const json_arena_scope scope(arena);
+
+	auto to = arena_json::parse(R"({"count": 2, "mean": 1.5, "name": "sensor", "enabled": true})");
+	const auto from = arena_json::parse(R"({"count": 3, "mean": 0.5})");
+
+	arithmetic_add_json_inplace(from, to);
+	CHECK(to["count"] == 5);
+	CHECK(arithmetic_sub_json(from, to)["mean"] == -1.5);
+
+	CHECK(value_ig_type(to, "name", std::string{}) == "sensor");
+	CHECK(value_ig_type(to, "count", 0) == 5);
+	CHECK(is_json_number(to, "mean"));
+	CHECK_FALSE(is_json_string(to, "count"));
+
+	std::string name;
+	bool enabled{false};
+	CHECK(checkedUpdateFromJSON(to, "name", name));
+	CHECK(checkedUpdateFromJSON(to, "enabled", enabled));
+	CHECK(name == "sensor");
+	CHECK(enabled);
+}
+
+TEST_CASE("json_path should look up nested values in one pass") {
+	const auto message = json::parse(R"({
+		"payload": {"data": {"channels": [{"rms": 1.0}, {"rms": 2.5, "name": "z", "enabled": true}]}}
+	})");
+
+	const json_path rms("/payload/data/channels/1/rms");
+
+	SECTION("values are extracted with their type checked") {
+		CHECK(rms.size() == 5);
+		CHECK(rms.get<double>(message) == 2.5);
+		CHECK(json_path("/payload/data/channels/1/name").get<std::string>(message) == "z");
+		CHECK(json_path("/payload/data/channels/1/enabled").get<bool>(message) == true);
+		CHECK(json_path("/payload/data/channels/1").get<json>(message) == message["payload"]["data"]["channels"][1]);
+	}
+
+	SECTION("find returns the node") {
+		CHECK(rms.find(message) == &message["payload"]["data"]["channels"][1]["rms"]);
+		CHECK(json_path("").find(message) == &message);
+		CHECK(json_path("/payload/missing").find(message) == nullptr);
+	}
+
+	SECTION("missing paths") {
+		CHECK(json_path("/payload/data/channels/2/rms").get<double>(message).error() == json_path_error::missing);
+		CHECK(json_path("/payload/other/rms").get<double>(message).error() == json_path_error::missing);
+		CHECK(json_path("/payload/data/channels/-").get<json>(message).error() == json_path_error::missing);
+		CHECK(json_path("/payload/data/channels/01").get<json>(message).error() == json_path_error::missing);
+		CHECK(rms.get<double>(json{{"payload", nullptr}}).error() == json_path_error::missing);
+	}
+
+	SECTION("type mismatches") {
+		CHECK(rms.get<std::string>(message).error() == json_path_error::type_mismatch);
+		CHECK(json_path("/payload/data/channels/1/name").get<int>(message).error() == json_path_error::type_mismatch);
+		CHECK(json_path("/payload/data/channels/1/rms/value").get<double>(message).error() ==
+			  json_path_error::type_mismatch);
+		CHECK(json_path("/payload/data/channels/1").get<std::vector<int>>(message).error() ==
+			  json_path_error::type_mismatch);
+	}
+
+	SECTION("keys that look like indices are looked up in objects") {
+		const json j = {{"values", {{"3", 7}}}};
+		CHECK(json_path("/values/3").get<int>(j) == 7);
+	}
+
+	SECTION("arena documents") {
+		json_arena arena;
+		const json_arena_scope scope(arena);
+
+		const auto j = arena_json::parse(message.dump());
+		CHECK(rms.get<double>(j) == 2.5);
+		CHECK(rms.find(j) == &j["payload"]["data"]["channels"][1]["rms"]);
+	}
+
+	CHECK_THROWS_AS(json_path("payload/data"), json::parse_error);
+}
@@ -1,13 +1,1116 @@
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
 #include "bone_helper/netHelper.hpp"
 #include "catch2/catch_all.hpp"
+#include "mock_server.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+	struct device_status {
+		double temperature{0.0};
+		int speed{0};
+		bool running{false};
+		std::string name{};
+		std::vector<double> values{};
+	};
+}  // namespace
+
+template <>
+struct bestsens::json_field_map<device_status> {
+	static constexpr auto fields = std::make_tuple(bestsens::json_field{"temperature", &device_status::temperature},
+												   bestsens::json_field{"speed", &device_status::speed},
+												   bestsens::json_field{"running", &device_status::running},
+												   bestsens::json_field{"name", &device_status::name},
+												   bestsens::json_field{"values", &device_status::values});
+};
+
+namespace {
+	auto echo_handler(const json& request) -> json {
+		if (request.at("command") == "error") {
+			return {{"command", "error"}, {"payload", {{"error", "command failed"}}}};
+		}
+
+		return {{"command", request.at("command")}, {"payload", request.value("payload", json::object())}};
+	}
+
+	// the dns cache is shared by all connections, so tests changing it restore the previous ttl
+	class dns_cache_ttl_guard {
+	public:
+		explicit dns_cache_ttl_guard(std::chrono::seconds ttl) : previous(bestsens::netHelper::get_dns_cache_ttl()) {
+			bestsens::netHelper::set_dns_cache_ttl(ttl);
+		}
+
+		~dns_cache_ttl_guard() {
+			bestsens::netHelper::set_dns_cache_ttl(this->previous);
+		}
+
+		dns_cache_ttl_guard(const dns_cache_ttl_guard&) = delete;
+		auto operator=(const dns_cache_ttl_guard&) -> dns_cache_ttl_guard& = delete;
+
+	private:
+		std::chrono::seconds previous;
+	};
+}  // namespace
 
 TEST_CASE("netHelper_test") {
-    /*
-     * open socket
-     */
-	auto* socket = new bestsens::jsonNetHelper("localhost", "6450");
-
-	CHECK(socket->get_sockfd() != 0);
-    CHECK(socket->is_logged_in() == 0);
-    
+	const auto use_msgpack = GENERATE(false, true);
+	const auto use_ssl = GENERATE(false, true);
+
+	const bestsens::test::mock_server server(echo_handler, use_msgpack, use_ssl);
+
+	bestsens::netHelper socket("127.0.0.1", server.port(), use_msgpack, true, use_ssl);
+
+	CHECK(socket.connect() == 0);
+	CHECK(socket.is_connected());
+	CHECK(socket.is_logged_in() == 0);
+
+	SECTION("send_command returns the full response") {
+		json response;
+		CHECK(socket.send_command("echo", response, {{"value", 42}}) == 1);
+		CHECK(response["command"] == "echo");
+		CHECK(response["payload"]["value"] == 42);
+	}
+
+	SECTION("getCommandReturnPayload returns the payload") {
+		const json payload = {{"value", "test\r\n"}, {"list", {1, 2, 3}}};
+		CHECK(socket.getCommandReturnPayload("echo", payload) == payload);
+	}
+
+	SECTION("getCommandReturnPayload throws on errors") {
+		CHECK_THROWS_AS(socket.getCommandReturnPayload("error"), std::runtime_error);
+	}
+
+	SECTION("prepared commands") {
+		auto command = socket.prepare("echo", {{"value", 1}});
+		CHECK(command.is_msgpack() == use_msgpack);
+		CHECK(socket.getCommandReturnPayload(command)["value"] == 1);
+		CHECK(socket.getCommandReturnPayload(command)["value"] == 1);
+
+		command.set_payload({{"value", "changed"}, {"list", {1, 2}}});
+		CHECK(socket.getCommandReturnPayload(command) == json({{"value", "changed"}, {"list", {1, 2}}}));
+
+		command.set_payload(nullptr);
+		CHECK(socket.getCommandReturnPayload(command) == json::object());
+
+		const auto other = bestsens::prepared_command("echo", {}, 0, !use_msgpack);
+		CHECK_THROWS_AS(socket.getCommandReturnPayload(other), std::invalid_argument);
+	}
+
+	SECTION("typed getCommandReturnPayload decodes into a struct") {
+		const json payload = {{"temperature", 21.5},
+							  {"speed", 1500},
+							  {"running", true},
+							  {"name", "bearing"},
+							  {"values", {1, 2.5, 3}},
+							  {"nested", {{"speed", 1}, {"values", {7}}}},
+							  {"unknown", "ignored"}};
+
+		const auto status = socket.getCommandReturnPayload<device_status>("echo", payload);
+		CHECK(status.temperature == 21.5);
+		CHECK(status.speed == 1500);
+		CHECK(status.running);
+		CHECK(status.name == "bearing");
+		CHECK(status.values == std::vector<double>{1, 2.5, 3});
+
+		CHECK_THROWS_AS(socket.getCommandReturnPayload<device_status>("error"), std::runtime_error);
+
+		// connection has to stay in sync
+		CHECK(socket.getCommandReturnPayload<device_status>("echo", {{"speed", 2}}).speed == 2);
+	}
+
+	SECTION("numeric_array_sax fills the array without a DOM") {
+		std::vector<double> values;
+		bestsens::numeric_array_sax<double> sax("data", values);
+
+		const std::vector<double> data(20000, 1.5);
+		CHECK(socket.send_command("echo", sax, {{"data", data}, {"other", {4, 5}}}) == 1);
+		CHECK(sax.found());
+		CHECK(values == data);
+
+		// connection has to stay in sync after streaming
+		CHECK(socket.getCommandReturnPayload("echo", {{"value", 1}})["value"] == 1);
+	}
+}
+
+TEST_CASE("netHelper streaming responses") {
+	const auto use_msgpack = GENERATE(false, true);
+
+	const auto series = [](size_t count) {
+		std::vector<double> data(count);
+		for (size_t i = 0; i < data.size(); ++i) {
+			data[i] = static_cast<double>(i) + 0.25;
+		}
+
+		return data;
+	};
+
+	// large responses to small requests, like waveform and history commands
+	const bestsens::test::mock_server server([&](const json& request) -> json {
+		if (request.at("command") == "series") {
+			const auto count = request.at("payload").at("count").get<size_t>();
+			return {{"command", "series"}, {"payload", {{"header", {{"count", count}}}, {"data", series(count)}}}};
+		}
+
+		return echo_handler(request);
+	}, use_msgpack);
+
+	bestsens::netHelper socket("127.0.0.1", server.port(), use_msgpack, true);
+	REQUIRE(socket.connect() == 0);
+
+	SECTION("responses spanning many chunks") {
+		const size_t count = 200000;
+
+		std::vector<double> values;
+		bestsens::numeric_array_sax<double> sax("data", values);
+
+		CHECK(socket.send_command("series", sax, {{"count", count}}) == 1);
+		CHECK(sax.found());
+		CHECK(values == series(count));
+	}
+
+	SECTION("error messages are kept") {
+		std::vector<int> values;
+		bestsens::numeric_array_sax<int> sax("data", values);
+
+		CHECK(socket.send_command("error", sax) == 1);
+		CHECK_FALSE(sax.found());
+		CHECK(sax.error() == "command failed");
+	}
+
+	SECTION("missing arrays are not reported as found") {
+		std::vector<int> values;
+		bestsens::numeric_array_sax<int> sax("data", values);
+
+		CHECK(socket.send_command("echo", sax, {{"other", {1, 2, 3}}}) == 1);
+		CHECK_FALSE(sax.found());
+		CHECK(values.empty());
+	}
+
+	SECTION("handlers can abort the parse") {
+		// stops at the first number, the rest of the frame has to be skipped
+		class abort_sax : public bestsens::numeric_array_sax<int> {
+		public:
+			using numeric_array_sax::numeric_array_sax;
+
+			auto number_integer(number_integer_t /*val*/) -> bool override {
+				return false;
+			}
+
+			auto number_unsigned(number_unsigned_t /*val*/) -> bool override {
+				return false;
+			}
+		};
+
+		std::vector<int> values;
+		abort_sax sax("data", values);
+
+		CHECK(socket.send_command("echo", sax, {{"data", std::vector<int>(100000, 7)}}) == 0);
+		CHECK(values.empty());
+	}
+
+	SECTION("exceptions of the handler drop the connection") {
+		class throwing_sax : public bestsens::numeric_array_sax<int> {
+		public:
+			using numeric_array_sax::numeric_array_sax;
+
+			auto number_unsigned(number_unsigned_t /*val*/) -> bool override {
+				throw std::runtime_error("handler failed");
+			}
+		};
+
+		std::vector<int> values;
+		throwing_sax sax("data", values);
+
+		CHECK_THROWS_AS(socket.send_command("echo", sax, {{"data", std::vector<int>(100000, 7)}}), std::runtime_error);
+
+		// the rest of the frame could not be skipped, the next command must not read it as its response
+		CHECK_FALSE(socket.is_connected());
+		REQUIRE(socket.connect() == 0);
+	}
+
+	// the connection has to stay in sync after streaming
+	CHECK(socket.getCommandReturnPayload("echo", {{"value", 1}})["value"] == 1);
+}
+
+TEST_CASE("netHelper sha512") {
+	CHECK(bestsens::netHelper::sha512("abc") ==
+		  "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+		  "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f");
+	CHECK(bestsens::netHelper::sha512("").size() == 128);
+}
+
+TEST_CASE("netHelper login") {
+	const auto password_hash = bestsens::netHelper::sha512("secret");
+	std::atomic<int> requests{0};
+	std::atomic<bool> accept_session{true};
+
+	const bestsens::test::mock_server server([&](const json& request) -> json {
+		++requests;
+
+		const auto& command = request.at("command");
+		const auto payload = request.value("payload", json::object());
+
+		if (command == "request_token") {
+			return {{"command", command}, {"payload", {{"token", "nonce"}}}};
+		}
+
+		if (command == "auth") {
+			if (payload.contains("session_token")) {
+				if (accept_session && payload["session_token"] == "session") {
+					return {{"command", command}, {"payload", {{"user_level", 1000}}}};
+				}
+
+				return {{"command", command}, {"payload", {{"error", "session expired"}}}};
+			}
+
+			if (payload.value("signed_token", "") == bestsens::netHelper::sha512(password_hash + "nonce")) {
+				return {{"command", command}, {"payload", {{"user_level", 1000}, {"session_token", "session"}}}};
+			}
+
+			return {{"command", command}, {"payload", {{"error", "wrong password"}, {"user_level", 0}}}};
+		}
+
+		return echo_handler(request);
+	});
+
+	bestsens::netHelper socket("127.0.0.1", server.port(), false, true);
+	socket.connect();
+
+	CHECK(socket.relogin() == 0);
+
+	CHECK(socket.login("user", "secret", false) == 1000);
+	CHECK(requests == 2);
+
+	// already logged in with the same credentials
+	CHECK(socket.login("user", password_hash) == 1000);
+	CHECK(requests == 2);
+
+	socket.disconnect();
+	CHECK(socket.is_logged_in() == 0);
+
+	socket.connect();
+
+	SECTION("session token is reused after a reconnect") {
+		CHECK(socket.relogin() == 1000);
+		CHECK(requests == 3);
+	}
+
+	SECTION("falls back to a full login if the session was rejected") {
+		accept_session = false;
+		CHECK(socket.relogin() == 1000);
+		CHECK(requests == 5);
+	}
+
+	SECTION("wrong password is not answered from the cache") {
+		CHECK(socket.login("user", "wrong", false) == 0);
+	}
+}
+
+TEST_CASE("prepared_command encoding") {
+	const json payload = {{"name", "test"}, {"values", {1.5, 2}}};
+	const auto api_version = GENERATE(0, 2);
+
+	json envelope = {{"command", "poll"}, {"payload", payload}};
+	if (api_version > 0) {
+		envelope["api"] = api_version;
+	}
+
+	const auto expected_msgpack = json::to_msgpack(envelope);
+
+	CHECK(bestsens::prepared_command("poll", payload, api_version).encoded() == envelope.dump() + "\r\n");
+	CHECK(bestsens::prepared_command("poll", payload, api_version, true).encoded() ==
+		  std::string(expected_msgpack.begin(), expected_msgpack.end()) + "\r\n");
+
+	bestsens::prepared_command command("poll", {}, api_version);
+	envelope.erase("payload");
+	CHECK(command.encoded() == envelope.dump() + "\r\n");
+
+	command.set_encoded_payload(payload.dump());
+	envelope["payload"] = payload;
+	CHECK(command.encoded() == envelope.dump() + "\r\n");
+}
+
+TEST_CASE("netHelper binary attachments") {
+	const std::vector<float> data{1.0f, 2.5f, -3.0f};
+
+	const bestsens::test::mock_server server([&](const json& request) -> json {
+		if (!request.value("binary_attachments", false)) {
+			return {{"command", "wave"}, {"payload", {{"data", data}}}};
+		}
+
+		std::vector<uint8_t> blob(data.size() * sizeof(float));
+		std::memcpy(blob.data(), data.data(), blob.size());
+
+		const auto command = request.at("command").get<std::string>();
+		const auto declared_size = command == "mismatch" ? blob.size() + 4 : blob.size();
+
+		const json envelope = {{"command", command},
+							   {"payload", {{"data", {{"$attachment", 0}}}}},
+							   {"attachments", {{{"type", "f32"}, {"size", declared_size}}, {{"type", "f32"}, {"size", blob.size()}}}}};
+
+		if (command == "broken") {
+			const std::string invalid = "{not json";
+			return json::array({json::binary({invalid.begin(), invalid.end()}), json::binary(blob), json::binary(blob)});
+		}
+
+		return json::array({envelope, json::binary(blob), json::binary(blob)});
+	});
+
+	bestsens::netHelper socket("127.0.0.1", server.port(), false, true);
+	socket.connect();
+
+	bestsens::binary_response response;
+
+	SECTION("attachments are referenced from the payload") {
+		REQUIRE(socket.send_command("wave", response) == 1);
+		CHECK(response.attachments.size() == 2);
+
+		const auto values = response.attachment<float>(response.envelope["payload"]["data"]);
+		CHECK(std::vector<float>(values.begin(), values.end()) == data);
+		CHECK_THROWS(response.attachment<double>(0));
+
+		CHECK(socket.getCommandReturnPayload("wave")["data"].size() == data.size());
+	}
+
+	SECTION("an unparsable envelope closes the connection") {
+		CHECK(socket.send_command("broken", response) == 0);
+		CHECK_FALSE(socket.is_connected());
+
+		REQUIRE(socket.connect() == 0);
+		CHECK(socket.getCommandReturnPayload("wave")["data"].size() == data.size());
+	}
+
+	SECTION("a failing attachment closes the connection") {
+		CHECK_THROWS_AS(socket.send_command("mismatch", response), std::runtime_error);
+		CHECK_FALSE(socket.is_connected());
+
+		REQUIRE(socket.connect() == 0);
+		REQUIRE(socket.send_command("wave", response) == 1);
+		CHECK(response.attachments.size() == 2);
+	}
+}
+
+TEST_CASE("netHelper compression") {
+	const auto use_msgpack = GENERATE(false, true);
+
+	bestsens::test::mock_server server(echo_handler, use_msgpack);
+
+	bestsens::netHelper socket("127.0.0.1", server.port(), use_msgpack, true);
+	REQUIRE(socket.connect() == 0);
+
+	const json payload = {{"data", std::vector<int>(10000, 7)}};
+
+	SECTION("servers without support stay uncompressed") {
+		server.set_compression_support(false);
+
+		CHECK_FALSE(socket.enable_compression(128));
+		CHECK_FALSE(socket.is_compression_enabled());
+		CHECK(socket.getCommandReturnPayload("echo", payload) == payload);
+		CHECK(server.compressed_requests() == 0);
+	}
+
+#ifdef ENABLE_ZSTD_COMPRESSION
+	SECTION("only payloads above the threshold are compressed") {
+		CHECK_FALSE(socket.is_compression_enabled());
+		REQUIRE(socket.enable_compression(128));
+		CHECK(socket.is_compression_enabled());
+
+		CHECK(socket.getCommandReturnPayload("echo", {{"small", 1}})["small"] == 1);
+		CHECK(server.compressed_requests() == 0);
+
+		CHECK(socket.getCommandReturnPayload("echo", payload) == payload);
+		CHECK(server.compressed_requests() == 1);
+
+		std::vector<int> values;
+		bestsens::numeric_array_sax<int> sax("data", values);
+		CHECK(socket.send_command("echo", sax, payload) == 1);
+		CHECK(values.size() == 10000);
+		CHECK(server.compressed_requests() == 2);
+
+		json response;
+		CHECK(socket.send_command("echo", response, payload) == 1);
+		CHECK(response["payload"] == payload);
+		CHECK(server.compressed_requests() == 3);
+	}
+
+	SECTION("compression has to be negotiated again after reconnecting") {
+		REQUIRE(socket.enable_compression(128));
+
+		socket.disconnect();
+		REQUIRE(socket.connect() == 0);
+
+		CHECK_FALSE(socket.is_compression_enabled());
+		CHECK(socket.getCommandReturnPayload("echo", payload) == payload);
+		CHECK(server.compressed_requests() == 0);
+	}
+#endif
+}
+
+TEST_CASE("netHelper subscription") {
+	const bestsens::test::mock_server server([](const json& request) -> json {
+		if (request.at("command") == "subscribe") {
+			auto frames = json::array({{{"command", "subscribe"}, {"payload", json::object()}}});
+
+			for (int i = 0; i < 10; ++i) {
+				frames.push_back({{"command", "push"}, {"payload", {{"value", i}}}});
+			}
+
+			return frames;
+		}
+
+		return echo_handler(request);
+	});
+
+	bestsens::netHelper socket("127.0.0.1", server.port(), false, true);
+	socket.connect();
+
+	std::atomic<int> received{0};
+	std::atomic<int> last_value{-1};
+
+	socket.subscribe("subscribe", [&](const json& frame) {
+		last_value = frame["payload"]["value"].get<int>();
+		++received;
+	}, {}, 2);
+
+	CHECK(socket.is_subscribed());
+	CHECK_THROWS_AS(socket.getCommandReturnPayload("echo"), std::logic_error);
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (received < 10 && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	socket.unsubscribe();
+
+	CHECK(received == 10);
+	CHECK(last_value == 9);
+	CHECK_FALSE(socket.is_subscribed());
+	CHECK(socket.getCommandReturnPayload("echo", {{"value", 1}})["value"] == 1);
+}
+
+TEST_CASE("netHelper subscription errors") {
+	const bestsens::test::mock_server server([](const json& request) -> json {
+		if (request.at("command") == "subscribe") {
+			auto frames = json::array({{{"command", "subscribe"}, {"payload", json::object()}}});
+
+			for (int i = 0; i < 5; ++i) {
+				frames.push_back({{"command", "push"}, {"payload", {{"value", i}}}});
+			}
+
+			if (request.value("payload", json::object()).value("fail", false)) {
+				const std::string invalid = "{not json";
+				frames.push_back(json::binary({invalid.begin(), invalid.end()}));
+			}
+
+			return frames;
+		}
+
+		// the protocol does not require responses to name the command
+		if (request.at("command") == "unsubscribe") {
+			return {{"payload", json::object()}};
+		}
+
+		return echo_handler(request);
+	});
+
+	bestsens::netHelper socket("127.0.0.1", server.port(), false, true);
+	socket.connect();
+
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::vector<int> values;
+
+	const auto wait_for = [&](size_t count) {
+		std::unique_lock<std::mutex> lock(mtx);
+		return cv.wait_for(lock, std::chrono::seconds(5), [&]() { return values.size() >= count; });
+	};
+
+	SECTION("exceptions of the callback do not end the subscription") {
+		socket.subscribe("subscribe", [&](const json& frame) {
+			const auto value = frame["payload"]["value"].get<int>();
+
+			{
+				const std::lock_guard<std::mutex> lock(mtx);
+				values.push_back(value);
+			}
+
+			cv.notify_all();
+
+			if (value % 2 == 0) {
+				throw std::runtime_error("callback failed");
+			}
+		});
+
+		REQUIRE(wait_for(5));
+		CHECK(values == std::vector<int>{0, 1, 2, 3, 4});
+		CHECK(socket.is_subscribed());
+
+		socket.unsubscribe();
+		CHECK(socket.getCommandReturnPayload("echo", {{"value", 1}})["value"] == 1);
+	}
+
+	SECTION("the subscription ends if the reader fails") {
+		socket.subscribe("subscribe", [&](const json& frame) {
+			{
+				const std::lock_guard<std::mutex> lock(mtx);
+				values.push_back(frame["payload"]["value"].get<int>());
+			}
+
+			cv.notify_all();
+		}, {{"fail", true}});
+
+		REQUIRE(wait_for(5));
+
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (socket.is_subscribed() && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		CHECK_FALSE(socket.is_subscribed());
+
+		// the invalid frame was received completely, the connection is still usable without unsubscribe()
+		CHECK(socket.getCommandReturnPayload("echo", {{"value", 2}})["value"] == 2);
+		CHECK(socket.getCommandReturnPayload("echo", {{"value", 3}})["value"] == 3);
+	}
+
+	SECTION("commands of the callback do not block clearing a failed subscription") {
+		std::atomic<bool> command_started{false};
+		std::atomic<bool> callback_rejected{false};
+
+		socket.subscribe("subscribe", [&](const json& frame) {
+			if (frame["payload"]["value"] == 0) {
+				// wait until the other thread tears down the failed subscription
+				const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+				while (!command_started && std::chrono::steady_clock::now() < deadline) {
+					std::this_thread::yield();
+				}
+
+				try {
+					socket.getCommandReturnPayload("echo");
+				} catch (const std::logic_error&) {
+					callback_rejected = true;
+				}
+			}
+
+			{
+				const std::lock_guard<std::mutex> lock(mtx);
+				values.push_back(frame["payload"]["value"].get<int>());
+			}
+
+			cv.notify_all();
+		}, {{"fail", true}});
+
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (socket.is_subscribed() && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		REQUIRE_FALSE(socket.is_subscribed());
+
+		command_started = true;
+		CHECK(socket.getCommandReturnPayload("echo", {{"value", 4}})["value"] == 4);
+
+		CHECK(callback_rejected);
+		CHECK(values == std::vector<int>{0, 1, 2, 3, 4});
+	}
+
+	SECTION("unsubscribe accepts responses without command") {
+		socket.subscribe("subscribe", [&](const json& frame) {
+			{
+				const std::lock_guard<std::mutex> lock(mtx);
+				values.push_back(frame["payload"]["value"].get<int>());
+			}
+
+			cv.notify_all();
+		});
+
+		REQUIRE(wait_for(5));
+
+		socket.set_timeout_ms(5000);
+
+		const auto start = std::chrono::steady_clock::now();
+		socket.unsubscribe();
+		CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+
+		CHECK(socket.getCommandReturnPayload("echo", {{"value", 5}})["value"] == 5);
+	}
+}
+
+TEST_CASE("netHelper fan_out") {
+	const auto slow_handler = [](const json& request) -> json {
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		return echo_handler(request);
+	};
+
+	std::vector<std::unique_ptr<bestsens::test::mock_server>> servers;
+	std::vector<bestsens::fanout_endpoint> endpoints;
+
+	for (int i = 0; i < 4; ++i) {
+		servers.push_back(std::make_unique<bestsens::test::mock_server>(slow_handler));
+		endpoints.push_back({"127.0.0.1", servers.back()->port()});
+	}
+
+	std::vector<bestsens::fanout_result> results;
+	const auto collect = [&](const bestsens::fanout_result& result) { results.push_back(result); };
+
+	SECTION("endpoints are queried concurrently") {
+		const auto start = std::chrono::steady_clock::now();
+		bestsens::fan_out(endpoints, "status", collect, {{"value", 1}}, {.concurrency = 4});
+
+		CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000));
+		REQUIRE(results.size() == 4);
+
+		for (const auto& result : results) {
+			CHECK(result.ok());
+			CHECK(result.payload["value"] == 1);
+		}
+	}
+
+	SECTION("failing hosts are reported without blocking the others") {
+		endpoints.push_back({"127.0.0.1", "1"});
+		bestsens::fan_out(endpoints, "status", collect, {}, {.concurrency = 2, .timeout_ms = 100});
+
+		REQUIRE(results.size() == 5);
+
+		for (const auto& result : results) {
+			CHECK_FALSE(result.ok());
+		}
+	}
+
+	SECTION("a throwing callback stops the fan out and is rethrown") {
+		int calls = 0;
+		const auto throwing = [&](const bestsens::fanout_result&) {
+			++calls;
+			throw std::runtime_error("callback failed");
+		};
+
+		CHECK_THROWS_AS(bestsens::fan_out(endpoints, "status", throwing, {}, {.concurrency = 2}), std::runtime_error);
+		CHECK(calls == 1);
+	}
+}
+
+TEST_CASE("netHelper fan_out login") {
+	const auto delay = std::chrono::milliseconds(200);
+
+	// each request takes less than timeout_ms, login and command together take longer
+	const bestsens::test::mock_server server([&](const json& request) -> json {
+		std::this_thread::sleep_for(delay);
+
+		const auto& command = request.at("command");
+		const auto payload = request.value("payload", json::object());
+
+		if (command == "request_token") {
+			return {{"command", command}, {"payload", {{"token", "nonce"}}}};
+		}
+
+		if (command == "auth") {
+			const auto level = payload.value("username", "") == "user" ? 1000 : 0;
+			return {{"command", command}, {"payload", {{"user_level", level}}}};
+		}
+
+		return echo_handler(request);
+	});
+
+	std::vector<bestsens::fanout_result> results;
+	const auto collect = [&](const bestsens::fanout_result& result) { results.push_back(result); };
+
+	SECTION("a rejected login is reported") {
+		const std::vector<bestsens::fanout_endpoint> endpoints{
+			{.target = "127.0.0.1", .port = server.port(), .user_name = "guest", .password = "secret"}};
+
+		bestsens::fan_out(endpoints, "status", collect, {}, {.timeout_ms = 2000});
+
+		REQUIRE(results.size() == 1);
+		CHECK(results[0].error == "login failed");
+		CHECK(results[0].payload.is_null());
+	}
+
+	SECTION("timeout_ms limits the whole exchange with one endpoint") {
+		const std::vector<bestsens::fanout_endpoint> endpoints{
+			{.target = "127.0.0.1", .port = server.port(), .user_name = "user", .password = "secret"}};
+
+		const auto start = std::chrono::steady_clock::now();
+		bestsens::fan_out(endpoints, "status", collect, {}, {.timeout_ms = 500});
+
+		CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(550));
+		REQUIRE(results.size() == 1);
+		CHECK_FALSE(results[0].ok());
+
+		results.clear();
+		bestsens::fan_out(endpoints, "status", collect, {{"value", 1}}, {.timeout_ms = 2000});
+
+		REQUIRE(results.size() == 1);
+		CHECK(results[0].ok());
+		CHECK(results[0].payload["value"] == 1);
+	}
+}
+
+TEST_CASE("netHelper metrics") {
+	const bestsens::test::mock_server server([](const json& request) -> json {
+		if (request.at("command") == "slow") {
+			std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		}
+
+		return echo_handler(request);
+	});
+
+	bestsens::netHelper socket("127.0.0.1", server.port(), false, true);
+	socket.connect();
+
+	for (int i = 0; i < 3; ++i) {
+		socket.getCommandReturnPayload("echo", {{"value", i}});
+	}
+
+	socket.set_timeout_ms(100);
+	CHECK_THROWS(socket.getCommandReturnPayload("slow"));
+
+	socket.disconnect();
+	socket.connect();
+
+	const auto metrics = socket.metrics();
+
+	if constexpr (bestsens::metrics_enabled) {
+		CHECK(metrics.connect.count == 2);
+		CHECK(metrics.reconnects == 1);
+		CHECK(metrics.command.count == 3);
+		CHECK(metrics.parse_json.count == 3);
+		CHECK(metrics.parse_msgpack.count == 0);
+		CHECK(metrics.timeouts == 1);
+		CHECK(metrics.bytes_sent > 0);
+		CHECK(metrics.bytes_received > 0);
+		CHECK(metrics.to_json()["command"]["count"] == 3);
+	} else {
+		CHECK(metrics.command.count == 0);
+		CHECK(metrics.bytes_sent == 0);
+	}
+}
+
+TEST_CASE("netHelper connect") {
+	const bestsens::test::mock_server server(echo_handler);
+
+	SECTION("resolves host names") {
+		bestsens::netHelper socket("localhost", server.port(), false, true);
+		CHECK(socket.connect() == 0);
+		CHECK(socket.getCommandReturnPayload("echo", {{"value", 1}})["value"] == 1);
+
+		// second connection is served from the dns cache
+		bestsens::netHelper cached("localhost", server.port(), false, true);
+		CHECK(cached.connect() == 0);
+		CHECK(cached.getCommandReturnPayload("echo", {{"value", 3}})["value"] == 3);
+	}
+
+	SECTION("reconnects") {
+		const dns_cache_ttl_guard ttl(std::chrono::seconds(0));
+
+		bestsens::netHelper socket("127.0.0.1", server.port(), false, true);
+		CHECK(socket.connect() == 0);
+		socket.disconnect();
+		CHECK(socket.connect() == 0);
+		CHECK(socket.getCommandReturnPayload("echo", {{"value", 2}})["value"] == 2);
+	}
+
+	SECTION("refused connections fail without waiting for the timeout") {
+		bestsens::netHelper socket("127.0.0.1", "1", false, true);
+		socket.set_timeout_ms(5000);
+
+		const auto start = std::chrono::steady_clock::now();
+		CHECK_THROWS_AS(socket.connect(), boost::system::system_error);
+		CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+		CHECK_FALSE(socket.is_connected());
+	}
+
+	SECTION("unresolvable endpoints fail") {
+		// numeric host with an unknown service name, fails without asking a dns server
+		bestsens::netHelper socket("127.0.0.1", "no such service", false, true);
+		CHECK_THROWS_AS(socket.connect(), boost::system::system_error);
+		CHECK_FALSE(socket.is_connected());
+	}
+}
+
+TEST_CASE("netHelper unix domain socket") {
+	const auto use_msgpack = GENERATE(false, true);
+	const auto path = fmt::format("/tmp/bone_helper_test_{}.sock", ::getpid());
+
+	const bestsens::test::mock_server server(echo_handler, use_msgpack, false, path);
+
+	bestsens::netHelper socket("unix:" + path, "", use_msgpack, true, true);
+
+	REQUIRE(socket.connect() == 0);
+	CHECK(socket.getCommandReturnPayload("echo", {{"value", 1}})["value"] == 1);
+
+	socket.disconnect();
+	CHECK_FALSE(socket.is_connected());
+
+	REQUIRE(socket.connect() == 0);
+	CHECK(socket.getCommandReturnPayload("echo", {{"value", 2}})["value"] == 2);
+}
+
+TEST_CASE("command_scheduler hands over in priority order") {
+	bestsens::detail::command_scheduler scheduler;
+
+	std::mutex order_mtx;
+	std::vector<std::string> order;
+
+	const auto schedule = [&](bestsens::command_priority priority, std::string name) {
+		return std::thread([&scheduler, &order_mtx, &order, priority, name = std::move(name)]() {
+			scheduler.acquire(priority);
+
+			{
+				const std::lock_guard<std::mutex> lock(order_mtx);
+				order.push_back(name);
+			}
+
+			scheduler.release();
+		});
+	};
+
+	// waits for the state of the scheduler, not for a guessed amount of time
+	const auto wait_queued = [&scheduler](size_t count) {
+		while (scheduler.queued() < count) {
+			std::this_thread::yield();
+		}
+	};
+
+	// command in flight
+	scheduler.acquire(bestsens::command_priority::bulk);
+
+	auto bulk = schedule(bestsens::command_priority::bulk, "bulk");
+	wait_queued(1);
+	auto normal = schedule(bestsens::command_priority::normal, "normal");
+	wait_queued(2);
+	auto high = schedule(bestsens::command_priority::high, "high");
+	wait_queued(3);
+
+	scheduler.release();
+
+	bulk.join();
+	normal.join();
+	high.join();
+
+	CHECK(order == std::vector<std::string>{"high", "normal", "bulk"});
+	CHECK(scheduler.queued() == 0);
+}
+
+TEST_CASE("netHelper bandwidth limit") {
+	const bestsens::test::mock_server server([](const json& request) -> json {
+		if (request.at("command") == "download") {
+			return {{"command", "download"}, {"payload", {{"data", std::string(50000, 'x')}}}};
+		}
+
+		return echo_handler(request);
+	});
+
+	bestsens::netHelper socket("127.0.0.1", server.port(), false, true);
+	socket.connect();
+
+	socket.set_bandwidth_limit(100000, 10000);
+
+	socket.getCommandReturnPayload("download");
+
+	// ~40 kB of debt have to be paid off before the next normal command
+	const auto start = std::chrono::steady_clock::now();
+	socket.getCommandReturnPayload("normal");
+	CHECK(std::chrono::steady_clock::now() - start > std::chrono::milliseconds(300));
+
+	socket.getCommandReturnPayload("download");
+
+	// high priority commands are not throttled
+	const auto high_start = std::chrono::steady_clock::now();
+	{
+		const bestsens::command_priority_scope scope(bestsens::command_priority::high);
+		socket.getCommandReturnPayload("alarm");
+	}
+	CHECK(std::chrono::steady_clock::now() - high_start < std::chrono::milliseconds(200));
+
+	socket.set_bandwidth_limit(0);
+}
+
+TEST_CASE("netHelper move") {
+	STATIC_REQUIRE(std::is_nothrow_move_constructible_v<bestsens::netHelper>);
+	STATIC_REQUIRE(std::is_nothrow_move_assignable_v<bestsens::netHelper>);
+
+	const auto use_ssl = GENERATE(false, true);
+	const bestsens::test::mock_server server(echo_handler, false, use_ssl);
+
+	SECTION("connections keep working inside a vector") {
+		std::vector<bestsens::netHelper> connections;
+
+		for (int i = 0; i < 8; ++i) {
+			auto& connection = connections.emplace_back("127.0.0.1", server.port(), false, true, use_ssl);
+			REQUIRE(connection.connect() == 0);
+		}
+
+		for (int i = 0; i < 8; ++i) {
+			CHECK(connections[static_cast<size_t>(i)].is_connected());
+			CHECK(connections[static_cast<size_t>(i)].getCommandReturnPayload("echo", {{"value", i}})["value"] == i);
+		}
+
+		connections.erase(connections.begin());
+		CHECK(connections.front().getCommandReturnPayload("echo", {{"value", 1}})["value"] == 1);
+	}
+
+	SECTION("move assignment replaces the connection") {
+		bestsens::netHelper a("127.0.0.1", server.port(), false, true, use_ssl);
+		bestsens::netHelper b("127.0.0.1", server.port(), false, true, use_ssl);
+		REQUIRE(a.connect() == 0);
+		REQUIRE(b.connect() == 0);
+
+		a = std::move(b);
+		CHECK(a.is_connected());
+		CHECK(a.getCommandReturnPayload("echo", {{"value", 2}})["value"] == 2);
+	}
+
+	SECTION("connections can be handed to another thread") {
+		bestsens::netHelper connection("127.0.0.1", server.port(), false, true, use_ssl);
+		REQUIRE(connection.connect() == 0);
+
+		json result;
+		std::thread worker([&result, moved = std::move(connection)]() mutable {
+			result = moved.getCommandReturnPayload("echo", {{"value", 3}});
+		});
+		worker.join();
+
+		CHECK(result["value"] == 3);
+	}
+
+	SECTION("subscriptions keep running when the connection is moved") {
+		bestsens::netHelper connection("127.0.0.1", server.port(), false, true, use_ssl);
+		REQUIRE(connection.connect() == 0);
+		connection.subscribe("subscribe", [](const json&) {});
+
+		auto moved = std::move(connection);
+		CHECK(moved.is_subscribed());
+
+		moved.unsubscribe();
+		CHECK(moved.getCommandReturnPayload("echo", {{"value", 4}})["value"] == 4);
+	}
+}
+
+TEST_CASE("netHelperTCP move") {
+	const bestsens::test::mock_server server(echo_handler);
+
+	SECTION("connections keep working inside a vector") {
+		std::vector<bestsens::detail::netHelperTCP> connections;
+
+		for (int i = 0; i < 8; ++i) {
+			auto& connection = connections.emplace_back("127.0.0.1", server.port(), false, true);
+			REQUIRE(connection.connect() == 0);
+		}
+
+		for (int i = 0; i < 8; ++i) {
+			CHECK(connections[static_cast<size_t>(i)].is_connected());
+			CHECK(connections[static_cast<size_t>(i)].getCommandReturnPayload("echo", {{"value", i}})["value"] == i);
+		}
+
+		connections.erase(connections.begin());
+		CHECK(connections.front().getCommandReturnPayload("echo", {{"value", 1}})["value"] == 1);
+	}
+
+	SECTION("moved-from connections are left disconnected") {
+		bestsens::detail::netHelperTCP connection("127.0.0.1", server.port(), false, true);
+		REQUIRE(connection.connect() == 0);
+
+		auto moved = std::move(connection);
+		CHECK_FALSE(connection.is_connected());  // NOLINT(bugprone-use-after-move)
+		CHECK(moved.is_connected());
+		CHECK(moved.getCommandReturnPayload("echo", {{"value", 2}})["value"] == 2);
+	}
+
+	SECTION("move assignment replaces the connection") {
+		bestsens::detail::netHelperTCP a("127.0.0.1", server.port(), false, true);
+		bestsens::detail::netHelperTCP b("127.0.0.1", server.port(), false, true);
+		REQUIRE(a.connect() == 0);
+		REQUIRE(b.connect() == 0);
+
+		a = std::move(b);
+		CHECK(a.is_connected());
+		CHECK_FALSE(b.is_connected());  // NOLINT(bugprone-use-after-move)
+		CHECK(a.getCommandReturnPayload("echo", {{"value", 3}})["value"] == 3);
+	}
+
+	SECTION("subscribed connections can not be moved") {
+		bestsens::detail::netHelperTCP connection("127.0.0.1", server.port(), false, true);
+		REQUIRE(connection.connect() == 0);
+		connection.subscribe("subscribe", [](const json&) {});
+
+		CHECK_THROWS_AS(bestsens::detail::netHelperTCP(std::move(connection)), std::logic_error);
+
+		bestsens::detail::netHelperTCP other("127.0.0.1", server.port(), false, true);
+		CHECK_THROWS_AS(other = std::move(connection), std::logic_error);
+
+		// the failed moves left the subscription untouched
+		CHECK(connection.is_subscribed());  // NOLINT(bugprone-use-after-move)
+
+		connection.unsubscribe();
+		CHECK(connection.getCommandReturnPayload("echo", {{"value", 4}})["value"] == 4);
+	}
+}
+
+TEST_CASE("netHelperUnix move") {
+	const auto path = fmt::format("/tmp/bone_helper_move_test_{}.sock", ::getpid());
+	const bestsens::test::mock_server server(echo_handler, false, false, path);
+
+	bestsens::detail::netHelperUnix a(path, false, true);
+	bestsens::detail::netHelperUnix b(path, false, true);
+	REQUIRE(a.connect() == 0);
+	REQUIRE(b.connect() == 0);
+
+	auto moved = std::move(a);
+	CHECK_FALSE(a.is_connected());  // NOLINT(bugprone-use-after-move)
+	CHECK(moved.getCommandReturnPayload("echo", {{"value", 1}})["value"] == 1);
+
+	moved = std::move(b);
+	CHECK_FALSE(b.is_connected());  // NOLINT(bugprone-use-after-move)
+	CHECK(moved.getCommandReturnPayload("echo", {{"value", 2}})["value"] == 2);
+}
+
+TEST_CASE("netHelperSSL move") {
+	const bestsens::test::mock_server server(echo_handler, false, true);
+
+	SECTION("moved-from connections are left disconnected") {
+		bestsens::detail::netHelperSSL connection("127.0.0.1", server.port(), false, true);
+		REQUIRE(connection.connect() == 0);
+
+		auto moved = std::move(connection);
+		CHECK_FALSE(connection.is_connected());  // NOLINT(bugprone-use-after-move)
+		CHECK(moved.getCommandReturnPayload("echo", {{"value", 1}})["value"] == 1);
+	}
+
+	SECTION("connections keep working inside a vector") {
+		std::vector<bestsens::detail::netHelperSSL> connections;
+
+		for (int i = 0; i < 4; ++i) {
+			auto& connection = connections.emplace_back("127.0.0.1", server.port(), false, true);
+			REQUIRE(connection.connect() == 0);
+		}
+
+		for (int i = 0; i < 4; ++i) {
+			CHECK(connections[static_cast<size_t>(i)].getCommandReturnPayload("echo", {{"value", i}})["value"] == i);
+		}
+	}
+
+	SECTION("subscribed connections can not be moved") {
+		bestsens::detail::netHelperSSL connection("127.0.0.1", server.port(), false, true);
+		REQUIRE(connection.connect() == 0);
+		connection.subscribe("subscribe", [](const json&) {});
+
+		CHECK_THROWS_AS(bestsens::detail::netHelperSSL(std::move(connection)), std::logic_error);
+		CHECK(connection.is_subscribed());  // NOLINT(bugprone-use-after-move)
+
+		connection.unsubscribe();
+	}
 }